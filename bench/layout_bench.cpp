@@ -0,0 +1,158 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "scheduler.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+// Reads one perf_event_open counter for the calling thread and the workers it spawns.
+class PerfCounter {
+public:
+    PerfCounter(uint32_t type, uint64_t config) {
+#ifdef __linux__
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+
+    ~PerfCounter() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+#endif
+    }
+
+    bool available() const {
+        return fd_ >= 0;
+    }
+
+    void start() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        if (fd_ < 0) {
+            return;
+        }
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t value = 0;
+        if (read(fd_, &value, sizeof(value)) == sizeof(value)) {
+            total_ += value;
+        }
+#endif
+    }
+
+    uint64_t total() const {
+        return total_;
+    }
+
+private:
+    int fd_ = -1;
+    uint64_t total_ = 0;
+};
+
+
+// Task ids interleave the chains while the frozen order runs each chain to completion, so walking
+// per-task state by id strides across the whole graph.
+void BuildChains(TTaskScheduler& scheduler, size_t chains, size_t length) {
+    const size_t count = chains * length;
+    auto builder = scheduler.builder();
+    builder.reserve(count, count - chains);
+    for (size_t id = 0; id < count; ++id) {
+        if (id + chains < count) {
+            builder.add([](uint64_t a) { return a + 1; }, builder.getFutureResult<uint64_t>(id + chains));
+        } else {
+            builder.add([]() { return uint64_t{0}; });
+        }
+    }
+    builder.commit();
+}
+
+int main(int argc, char** argv) {
+    size_t chains = argc > 1 ? std::stoul(argv[1]) : 64;
+    size_t length = argc > 2 ? std::stoul(argv[2]) : 4096;
+    size_t threads = argc > 3 ? std::stoul(argv[3]) : 0;
+    size_t rounds = argc > 4 ? std::stoul(argv[4]) : 5;
+
+#ifdef __linux__
+    struct Metric {
+        const char* name;
+        PerfCounter counter;
+    };
+    Metric metrics[] = {
+        {"cache-misses", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}},
+        {"cache-refs", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES}},
+        {"instructions", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}},
+        {"task-clock-ns", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK}},
+        {"page-faults", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}},
+    };
+#endif
+
+    ExecutorOptions options;
+    options.threads = threads;
+    std::chrono::nanoseconds elapsed{0};
+    for (size_t round = 0; round < rounds; ++round) {
+        TTaskScheduler scheduler;
+        BuildChains(scheduler, chains, length);
+        scheduler.freeze();
+
+#ifdef __linux__
+        for (auto& metric : metrics) {
+            metric.counter.start();
+        }
+#endif
+        const auto start = std::chrono::steady_clock::now();
+        if (threads == 0) {
+            scheduler.executeAll();
+        } else {
+            scheduler.executeParallel(options);
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+#ifdef __linux__
+        for (auto& metric : metrics) {
+            metric.counter.stop();
+        }
+#endif
+    }
+
+    const double tasks = static_cast<double>(chains * length * rounds);
+    std::printf("%zu chains x %zu tasks, %zu rounds, %s\n", chains, length, rounds,
+                threads == 0 ? "executeAll" : ("executeParallel, " + std::to_string(threads) + " threads").c_str());
+    std::printf("%-14s %10.2f per task\n", "wall-ns", static_cast<double>(elapsed.count()) / tasks);
+#ifdef __linux__
+    for (const auto& metric : metrics) {
+        if (metric.counter.available()) {
+            std::printf("%-14s %10.2f per task\n", metric.name, static_cast<double>(metric.counter.total()) / tasks);
+        } else {
+            std::printf("%-14s %10s\n", metric.name, "unavailable");
+        }
+    }
+#endif
+    return 0;
+}
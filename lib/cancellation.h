@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+
+class CancellationToken {
+public:
+    using Clock = std::chrono::steady_clock;
+
+public:
+    CancellationToken() = default;
+
+    static CancellationToken Create() {
+        CancellationToken token;
+        token.state_ = std::make_shared<State>();
+        return token;
+    }
+
+    static CancellationToken WithDeadline(Clock::time_point deadline) {
+        CancellationToken token = Create();
+        token.state_->deadline = deadline;
+        return token;
+    }
+
+    template<typename Rep, typename Period>
+    static CancellationToken WithTimeout(std::chrono::duration<Rep, Period> timeout) {
+        return WithDeadline(Clock::now() +
+                            std::chrono::duration_cast<Clock::duration>(timeout));
+    }
+
+public:
+    void cancel() {
+        if (state_) {
+            state_->cancelled.store(true, std::memory_order_release);
+        }
+    }
+
+    bool isCancelled() const {
+        if (!state_) {
+            return false;
+        }
+        if (state_->cancelled.load(std::memory_order_acquire)) {
+            return true;
+        }
+        return state_->deadline != Clock::time_point::max()
+            && Clock::now() >= state_->deadline;
+    }
+
+    bool isCancellable() const {
+        return state_ != nullptr;
+    }
+
+    Clock::time_point deadline() const {
+        return state_ ? state_->deadline : Clock::time_point::max();
+    }
+
+private:
+    struct State {
+        std::atomic<bool> cancelled = false;
+        Clock::time_point deadline = Clock::time_point::max();
+    };
+
+private:
+    std::shared_ptr<State> state_;
+};
+
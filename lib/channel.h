@@ -0,0 +1,95 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+
+
+template<typename T>
+class Channel {
+public:
+    explicit Channel(size_t capacity)
+        : capacity_(capacity ? capacity : 1)
+    {}
+
+    Channel(const Channel& other) = delete;
+
+    Channel& operator=(const Channel& other) = delete;
+
+public:
+    bool push(T value) {
+        std::unique_lock lock(mutex_);
+        not_full_.wait(lock, [this] { return closed_ || chunks_.size() < capacity_; });
+        if (closed_) {
+            dropped_ = true;
+            return false;
+        }
+        chunks_.push_back(std::move(value));
+        if (ready_) {
+            not_empty_.notify_one();
+        } else {
+            ready_ = true;
+            not_empty_.notify_all();
+        }
+        return true;
+    }
+
+    std::optional<T> pop() {
+        std::unique_lock lock(mutex_);
+        not_empty_.wait(lock, [this] { return closed_ || !chunks_.empty(); });
+        if (chunks_.empty()) {
+            if (error_) {
+                std::rethrow_exception(error_);
+            }
+            return std::nullopt;
+        }
+        T value = std::move(chunks_.front());
+        chunks_.pop_front();
+        not_full_.notify_one();
+        return value;
+    }
+
+    void close(std::exception_ptr error = nullptr) {
+        std::lock_guard lock(mutex_);
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+        error_ = error;
+        ready_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    bool isClosed() const {
+        std::lock_guard lock(mutex_);
+        return closed_;
+    }
+
+    bool dropped() const {
+        std::lock_guard lock(mutex_);
+        return dropped_;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    void waitReady() {
+        std::unique_lock lock(mutex_);
+        not_empty_.wait(lock, [this] { return ready_; });
+    }
+
+private:
+    const size_t capacity_;
+    std::deque<T> chunks_;
+    bool closed_ = false;
+    bool ready_ = false;
+    bool dropped_ = false;
+    std::exception_ptr error_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
@@ -15,7 +15,7 @@ public:
         if (this == &other) {
             return *this;
         }
-        content_ = nullptr;
+        Reset();
         content_ = other.content_ ? other.content_->GetCopy() : nullptr;
         return *this;
     }
@@ -30,7 +30,7 @@ public:
         if (this == &other) {
             return *this;
         }
-        content_ = nullptr;
+        Reset();
         content_ = other.content_;
         other.content_ = nullptr;
         return *this;
@@ -48,6 +48,7 @@ public:
 
     template<typename T>
     Any& operator=(const T& value) {
+        Reset();
         content_ = new Holder<T>(value);
         return *this;
     }
@@ -55,6 +56,7 @@ public:
 public:
     void Reset() {
         delete content_;
+        content_ = nullptr;
     }
 
     template<typename T>
@@ -112,7 +114,7 @@ private:
     friend T& AnyCast(Any& other);
 
 private:
-    PlHolder* content_;
+    PlHolder* content_ = nullptr;
 };
 
 
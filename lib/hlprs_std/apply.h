@@ -25,4 +25,23 @@ auto Apply(Func&& func, Tuple&& tuple) {
 }
 
 
+
+template <typename Func, typename Tuple, typename Transform, size_t... Indexes>
+auto ApplyTransformedImpl(Func&& func, Tuple&& tuple, Transform&& transform, IndexSequence<Indexes...>) {
+    return Invoke(std::forward<Func>(func),
+                    transform(Get<Indexes>(std::forward<Tuple>(tuple)))...);
+}
+
+
+template <typename Func, typename Tuple, typename Transform>
+auto ApplyTransformed(Func&& func, Tuple&& tuple, Transform&& transform) {
+    constexpr size_t size = TupleSize<std::decay_t<Tuple>>::value;
+    using Indexes = MakeIndexSequence<size>;
+
+    return ApplyTransformedImpl(std::forward<Func>(func),
+                    std::forward<Tuple>(tuple),
+                    std::forward<Transform>(transform),
+                    Indexes{});
+}
+
 }
\ No newline at end of file
@@ -1,196 +1,154 @@
 #pragma once
 
+#include <type_traits>
+#include <utility>
+
 #include "invoke.h"
 
 namespace dts {
 
 
+template <size_t... Ind>
+struct IndexSequence {};
+
+
+template <size_t N, size_t... Ind>
+struct MakeIndexSequenceImpl : MakeIndexSequenceImpl<N - 1, N - 1, Ind...> {};
+
+
+template <size_t... Ind>
+struct MakeIndexSequenceImpl<0, Ind...> {
+    using type = IndexSequence<Ind...>;
+};
+
+
+template <size_t N>
+using MakeIndexSequence = typename MakeIndexSequenceImpl<N>::type;
+
+
 template <size_t Index, typename T>
 class TupleElement {
 public:
     TupleElement() = default;
 
-    TupleElement(T&& val) 
-        : value(std::forward<T>(val)) 
+    template <typename U>
+    TupleElement(U&& val)
+        : value(std::forward<U>(val))
     {}
 
-    T& get() { 
-        return value; 
+    T& get() & {
+        return value;
     }
-    
-    const T& get() const { 
-        return value; 
+
+    const T& get() const & {
+        return value;
     }
-    
+
+    T&& get() && {
+        return std::forward<T>(value);
+    }
+
 private:
     T value;
 };
 
 
-template <typename... Tail>
-class Tuple;
-
-
-template<>
-class Tuple<> {
-};
-
-template <typename Head>
-class Tuple<Head> {
-public:
-    Tuple() = default;
+template <typename Indexes, typename... Types>
+class TupleStorage;
 
-    Tuple(Head&& head) 
-        : head(std::forward<Head>(head))
-    {}
 
+template <size_t... Indexes, typename... Types>
+class TupleStorage<IndexSequence<Indexes...>, Types...> : public TupleElement<Indexes, Types>... {
 public:
-    Tuple(const Tuple& other) 
-        : head(other.head) 
-    {}
+    TupleStorage() = default;
 
-    Tuple& operator=(const Tuple& other) {
-        if (this == &other) {
-            return *this;
-        }
-        head = other.head;
-        return *this;
-    }
-
-    Tuple(Tuple&& other) noexcept 
-        : head(std::move(other.head)) 
+    template <typename... Args>
+    TupleStorage(Args&&... args)
+        : TupleElement<Indexes, Types>(std::forward<Args>(args))...
     {}
+};
 
-    Tuple& operator=(Tuple&& other) noexcept {
-        if (this == &other) {
-            return *this;
-        }
-        head = std::move(other.head);
-        return *this;
-    }
-
-    ~Tuple() = default;
 
-public:
-    Head head;
-};
+template <typename... Types>
+class Tuple : public TupleStorage<MakeIndexSequence<sizeof...(Types)>, Types...> {
+private:
+    using Storage = TupleStorage<MakeIndexSequence<sizeof...(Types)>, Types...>;
 
+    template <typename... Args>
+    static constexpr bool kIsCopyOrMove = sizeof...(Args) == 1
+        && (std::is_same_v<std::remove_cvref_t<Args>, Tuple> && ...);
 
-template <typename Head, typename... Tail>
-class Tuple<Head, Tail...> {
 public:
     Tuple() = default;
 
-    Tuple(Head&& head, Tail... tail) 
-        : tail(std::forward<Tail>(tail)...)
-        , head(std::forward<Head>(head))
+    template <typename... Args>
+        requires (sizeof...(Args) == sizeof...(Types) && sizeof...(Args) > 0 && !kIsCopyOrMove<Args...>)
+    Tuple(Args&&... args)
+        : Storage(std::forward<Args>(args)...)
     {}
 
-public:
-    Tuple(const Tuple& other) 
-        : tail(other.tuple)
-        , head(other.head) 
-    {}
+    Tuple(const Tuple& other) = default;
 
-    Tuple& operator=(const Tuple& other) {
-        if (this == &other) {
-            return *this;
-        }
-        tail = other.tail;
-        head = other.head;
-        return *this;
-        
-    }
+    Tuple& operator=(const Tuple& other) = default;
 
-    Tuple(Tuple&& other) noexcept 
-        : tail(std::move(other.tail))
-        , head(std::move(other.head)) 
-    {}
+    Tuple(Tuple&& other) noexcept = default;
 
-    Tuple& operator=(Tuple&& other) noexcept {
-        if (this == &other) {
-            return *this;
-        }
-        tail = std::move(other.tail);
-        head = std::move(other.head);
-        return *this;
-    }
+    Tuple& operator=(Tuple&& other) noexcept = default;
 
     ~Tuple() = default;
-
-public:
-    Head head;
-    Tuple<Tail...> tail;
 };
 
 
-template <size_t Index, typename Head, typename... Tail>
-auto& Get(Tuple<Head, Tail...>& tuple) {
-    if constexpr (Index == 0) {
-        return tuple.head;
-    } else {
-        return Get<Index - 1>(tuple.tail);
-    }
+template <size_t Index, typename T>
+T& GetElement(TupleElement<Index, T>& element) {
+    return element.get();
 }
 
 
-template <size_t Index, typename Head, typename... Tail>
-const auto& Get(const Tuple<Head, Tail...>& tuple) {
-    if constexpr (Index == 0) {
-        return tuple.head;
-    } else {
-        return Get<Index - 1>(tuple.tail);
-    }
+template <size_t Index, typename T>
+const T& GetElement(const TupleElement<Index, T>& element) {
+    return element.get();
 }
 
 
-template <size_t Index, typename Head, typename... Tail>
-auto&& Get(Tuple<Head, Tail...>&& tuple) {
-    if constexpr (Index == 0) {
-        return std::forward<Head>(tuple.head);
-    } else {
-        return Get<Index - 1>(std::forward<Tuple<Tail...>>(tuple.tail));
-    }
+template <size_t Index, typename T>
+T&& GetElement(TupleElement<Index, T>&& element) {
+    return std::move(element).get();
 }
 
 
-template<typename... Args>
-Tuple<Args...> MakeTuple(Args&&... args) {
-    return Tuple<Args...>(std::forward<Args>(args)...);
+template <size_t Index, typename... Types>
+auto& Get(Tuple<Types...>& tuple) {
+    return GetElement<Index>(tuple);
 }
 
 
-template <typename>
-struct TupleSize;
-
+template <size_t Index, typename... Types>
+const auto& Get(const Tuple<Types...>& tuple) {
+    return GetElement<Index>(tuple);
+}
 
-template <>
-struct TupleSize<Tuple<>> {
-    static constexpr size_t value = 0;
-};
 
-template <typename Head, typename... Tail>
-struct TupleSize<Tuple<Head, Tail...>> {
-    static constexpr size_t value = 1 + TupleSize<Tuple<Tail...>>::value;
-};
+template <size_t Index, typename... Types>
+auto&& Get(Tuple<Types...>&& tuple) {
+    return GetElement<Index>(std::move(tuple));
+}
 
 
-template <size_t... Ind>
-struct IndexSequence {};
+template<typename... Args>
+Tuple<Args...> MakeTuple(Args&&... args) {
+    return Tuple<Args...>(std::forward<Args>(args)...);
+}
 
 
-template <size_t N, size_t... Ind>
-struct MakeIndexSequenceImpl : MakeIndexSequenceImpl<N - 1, N - 1, Ind...> {};
+template <typename>
+struct TupleSize;
 
 
-template <size_t... Ind>
-struct MakeIndexSequenceImpl<0, Ind...> {
-    using type = IndexSequence<Ind...>;
+template <typename... Types>
+struct TupleSize<Tuple<Types...>> {
+    static constexpr size_t value = sizeof...(Types);
 };
 
 
-template <size_t N>
-using MakeIndexSequence = typename MakeIndexSequenceImpl<N>::type;
-
-
-}
\ No newline at end of file
+}
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "cancellation.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+
+class IoEventLoop {
+public:
+    using Clock = CancellationToken::Clock;
+    using Handler = std::function<bool()>;
+    using Completion = std::function<void(bool cancelled)>;
+
+#ifdef __linux__
+    static constexpr uint32_t kReadable = EPOLLIN;
+    static constexpr uint32_t kWritable = EPOLLOUT;
+#else
+    static constexpr uint32_t kReadable = 1;
+    static constexpr uint32_t kWritable = 4;
+#endif
+    static constexpr size_t kFileReaders = 4;
+    static constexpr std::chrono::milliseconds kCancelPollInterval{10};
+
+public:
+    IoEventLoop() {
+#ifdef __linux__
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "epoll_create1");
+        }
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wake_fd_ < 0) {
+            int error = errno;
+            close(epoll_fd_);
+            throw std::system_error(error, std::generic_category(), "eventfd");
+        }
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = wake_fd_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+        thread_ = std::thread([this] { Loop(); });
+#endif
+    }
+
+    ~IoEventLoop() {
+#ifdef __linux__
+        {
+            std::lock_guard lock(mutex_);
+            stopping_.store(true);
+        }
+        files_cv_.notify_all();
+        for (auto& reader : file_readers_) {
+            reader.join();
+        }
+        Wake();
+        thread_.join();
+        close(wake_fd_);
+        close(epoll_fd_);
+#endif
+    }
+
+    IoEventLoop(const IoEventLoop& other) = delete;
+
+    IoEventLoop& operator=(const IoEventLoop& other) = delete;
+
+public:
+    // A watch whose token is cancelled or whose deadline passes is dropped and completed with cancelled set.
+    void watch(int fd, uint32_t events, Handler handler, Completion on_complete,
+               CancellationToken token = {}, Clock::time_point deadline = Clock::time_point::max()) {
+#ifdef __linux__
+        int flags = fcntl(fd, F_GETFL);
+        if (flags >= 0 && !(flags & O_NONBLOCK)) {
+            fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        }
+
+        std::lock_guard lock(mutex_);
+        deadline = std::min(deadline, token.deadline());
+        bool guarded = token.isCancellable() || deadline != Clock::time_point::max();
+        Take(fd);
+        watches_[fd] = Watch{events, std::move(handler), std::move(on_complete), std::move(token), deadline, guarded};
+        if (guarded) {
+            ++guarded_;
+            Wake();
+        }
+
+        epoll_event event{};
+        event.events = events | EPOLLONESHOT;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == 0) {
+            return;
+        }
+        if (errno == EEXIST && epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) == 0) {
+            return;
+        }
+        if (errno == EPERM) {
+            pending_files_.push_back(fd);
+            if (pending_files_.size() > idle_readers_ && file_readers_.size() < kFileReaders) {
+                file_readers_.emplace_back([this] { ReadFiles(); });
+            }
+            files_cv_.notify_one();
+            return;
+        }
+
+        int error = errno;
+        Take(fd);
+        throw std::system_error(error, std::generic_category(), "epoll_ctl");
+#else
+        while (!handler()) {
+        }
+        on_complete(false);
+#endif
+    }
+
+private:
+    struct Watch {
+        uint32_t events = 0;
+        Handler handler;
+        Completion on_complete;
+        CancellationToken token;
+        Clock::time_point deadline = Clock::time_point::max();
+        bool guarded = false;
+    };
+
+private:
+#ifdef __linux__
+    void Loop() {
+        constexpr int kMaxEvents = 256;
+        epoll_event events[kMaxEvents];
+
+        while (!stopping_.load()) {
+            std::deque<Completion> finished;
+            {
+                std::lock_guard lock(mutex_);
+                finished.swap(finished_files_);
+            }
+            for (auto& on_complete : finished) {
+                on_complete(false);
+            }
+
+            int count = epoll_wait(epoll_fd_, events, kMaxEvents, WaitTimeout());
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == wake_fd_) {
+                    uint64_t value;
+                    while (read(wake_fd_, &value, sizeof(value)) > 0) {
+                    }
+                    continue;
+                }
+                Dispatch(fd);
+            }
+            CancelExpired();
+        }
+    }
+
+    int WaitTimeout() {
+        std::lock_guard lock(mutex_);
+        if (guarded_ == 0) {
+            return -1;
+        }
+        Clock::duration wait = std::chrono::minutes(1);
+        const auto now = Clock::now();
+        for (const auto& [fd, watch] : watches_) {
+            if (watch.token.isCancellable()) {
+                wait = std::min<Clock::duration>(wait, kCancelPollInterval);
+            }
+            if (watch.deadline != Clock::time_point::max()) {
+                wait = std::min(wait, std::max(watch.deadline - now, Clock::duration::zero()));
+            }
+        }
+        return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(wait).count());
+    }
+
+    void CancelExpired() {
+        std::vector<Watch> expired;
+        {
+            std::lock_guard lock(mutex_);
+            if (guarded_ == 0) {
+                return;
+            }
+            const auto now = Clock::now();
+            std::vector<int> fds;
+            for (const auto& [fd, watch] : watches_) {
+                if (watch.guarded && (now >= watch.deadline || watch.token.isCancelled())) {
+                    fds.push_back(fd);
+                }
+            }
+            for (int fd : fds) {
+                epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+                std::erase(pending_files_, fd);
+                expired.push_back(Take(fd));
+            }
+        }
+        for (auto& watch : expired) {
+            watch.on_complete(true);
+        }
+    }
+
+    void Dispatch(int fd) {
+        Handler handler;
+        uint32_t events = 0;
+        {
+            std::lock_guard lock(mutex_);
+            auto it = watches_.find(fd);
+            if (it == watches_.end()) {
+                return;
+            }
+            handler = it->second.handler;
+            events = it->second.events;
+        }
+
+        if (!handler()) {
+            epoll_event event{};
+            event.events = events | EPOLLONESHOT;
+            event.data.fd = fd;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+            return;
+        }
+
+        Watch watch;
+        {
+            std::lock_guard lock(mutex_);
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+            watch = Take(fd);
+        }
+        watch.on_complete(false);
+    }
+
+    // Regular files cannot be polled, so they are read by a few helper threads; completions still run on
+    // the loop thread, which keeps it the only thread finishing tasks.
+    void ReadFiles() {
+        std::unique_lock lock(mutex_);
+        while (true) {
+            ++idle_readers_;
+            files_cv_.wait(lock, [this] { return stopping_.load() || !pending_files_.empty(); });
+            --idle_readers_;
+            if (stopping_.load()) {
+                return;
+            }
+
+            int fd = pending_files_.front();
+            pending_files_.pop_front();
+            Watch watch = Take(fd);
+            if (!watch.handler) {
+                continue;
+            }
+            lock.unlock();
+            while (!watch.handler()) {
+            }
+            lock.lock();
+            finished_files_.push_back(std::move(watch.on_complete));
+            Wake();
+        }
+    }
+
+    Watch Take(int fd) {
+        auto it = watches_.find(fd);
+        if (it == watches_.end()) {
+            return {};
+        }
+        Watch watch = std::move(it->second);
+        watches_.erase(it);
+        if (watch.guarded) {
+            --guarded_;
+        }
+        return watch;
+    }
+
+    void Wake() {
+        uint64_t one = 1;
+        [[maybe_unused]] auto written = write(wake_fd_, &one, sizeof(one));
+    }
+#endif
+
+private:
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    std::atomic<bool> stopping_ = false;
+    std::mutex mutex_;
+    std::unordered_map<int, Watch> watches_;
+    std::deque<int> pending_files_;
+    std::deque<Completion> finished_files_;
+    std::condition_variable files_cv_;
+    std::vector<std::thread> file_readers_;
+    size_t idle_readers_ = 0;
+    size_t guarded_ = 0;
+    std::thread thread_;
+};
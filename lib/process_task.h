@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "cancellation.h"
+#include "result_codec.h"
+#include "task_errors.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+
+struct IsolationOptions {
+    std::chrono::milliseconds timeout{0};
+    CancellationToken token;
+};
+
+
+template<typename T>
+inline constexpr bool kHoldsAddress = std::is_pointer_v<T> || std::is_member_pointer_v<T>;
+
+template<typename T>
+inline constexpr bool kHoldsAddress<std::vector<T>> = kHoldsAddress<T>;
+
+
+// The child is forked from a multi-threaded process and only inherits the calling thread: a lock held by
+// another worker at fork time stays locked forever in the child. The timeout and the token bound how long
+// the parent waits for such a child before killing it.
+template<typename Result, typename Fn>
+Result RunInChildProcess(Fn&& fn, const IsolationOptions& options = {}) {
+    static_assert(!kHoldsAddress<Result>, "Addresses returned from a child process are meaningless in the parent");
+#ifdef __linux__
+    int fd = memfd_create("ttask-result", MFD_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "memfd_create");
+    }
+
+    auto write_segment = [fd](size_t size, auto&& write) {
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            return false;
+        }
+        if (size == 0) {
+            return true;
+        }
+        void* ptr = mmap(nullptr, size, PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED) {
+            return false;
+        }
+        write(static_cast<std::byte*>(ptr));
+        munmap(ptr, size);
+        return true;
+    };
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "fork");
+    }
+
+    if (pid == 0) {
+        int code = 2;
+        try {
+            Result result = fn();
+            size_t size = ResultCodec<Result>::Size(result);
+            code = write_segment(size, [&](std::byte* out) {
+                ResultCodec<Result>::Write(result, out);
+            }) ? 0 : 2;
+        } catch (const std::exception& e) {
+            std::string message = e.what();
+            write_segment(message.size(), [&](std::byte* out) {
+                std::memcpy(out, message.data(), message.size());
+            });
+            code = 1;
+        } catch (...) {
+            code = 1;
+        }
+        _exit(code);
+    }
+
+    int status = 0;
+    if (options.timeout.count() == 0 && !options.token.isCancellable()) {
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+        }
+    } else {
+        const auto deadline = options.timeout.count() > 0
+            ? CancellationToken::Clock::now() + options.timeout
+            : CancellationToken::Clock::time_point::max();
+        auto pause = std::chrono::microseconds(50);
+        while (true) {
+            pid_t done = waitpid(pid, &status, WNOHANG);
+            if (done == pid || (done < 0 && errno != EINTR)) {
+                break;
+            }
+            bool expired = CancellationToken::Clock::now() >= deadline;
+            if (expired || options.token.isCancelled()) {
+                kill(pid, SIGKILL);
+                while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+                }
+                close(fd);
+                throw TaskProcessError(pid, expired ? "worker process timed out" : "worker process was cancelled");
+            }
+            std::this_thread::sleep_for(pause);
+            pause = std::min(pause * 2, std::chrono::microseconds(10000));
+        }
+    }
+
+    struct stat info {};
+    fstat(fd, &info);
+    size_t size = static_cast<size_t>(info.st_size);
+    void* ptr = size ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : nullptr;
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "mmap");
+    }
+    const std::byte* segment = static_cast<const std::byte*>(ptr);
+
+    auto unmap = [&] {
+        if (ptr) {
+            munmap(ptr, size);
+        }
+    };
+
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        try {
+            Result result = ResultCodec<Result>::Read(segment, size);
+            unmap();
+            return result;
+        } catch (...) {
+            unmap();
+            throw;
+        }
+    }
+
+    std::string message;
+    if (WIFSIGNALED(status)) {
+        message = "worker process killed by signal " + std::to_string(WTERMSIG(status));
+    } else if (WIFEXITED(status) && WEXITSTATUS(status) == 1) {
+        message = size ? std::string(reinterpret_cast<const char*>(segment), size)
+                       : std::string("worker process threw an unknown exception");
+    } else {
+        message = "worker process failed to publish its result";
+    }
+    unmap();
+    throw TaskProcessError(pid, message);
+#else
+    return fn();
+#endif
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cctype>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+struct ResourceRequirement {
+    std::string name;
+    uint64_t amount = 0;
+};
+
+
+class TaskResources {
+public:
+    TaskResources() = default;
+
+    TaskResources(std::initializer_list<std::string_view> specs) {
+        for (std::string_view spec : specs) {
+            ResourceRequirement requirement = Parse(spec);
+            bool merged = false;
+            for (auto& existing : requirements_) {
+                if (existing.name == requirement.name) {
+                    existing.amount += requirement.amount;
+                    merged = true;
+                    break;
+                }
+            }
+            if (!merged) {
+                requirements_.push_back(std::move(requirement));
+            }
+        }
+    }
+
+public:
+    const std::vector<ResourceRequirement>& requirements() const {
+        return requirements_;
+    }
+
+    bool empty() const {
+        return requirements_.empty();
+    }
+
+    static ResourceRequirement Parse(std::string_view spec) {
+        size_t colon = spec.find(':');
+        std::string_view name = spec.substr(0, colon);
+        if (name.empty()) {
+            throw std::invalid_argument("Resource spec without a name: \"" + std::string(spec) + "\"");
+        }
+        if (colon == std::string_view::npos) {
+            return {std::string(name), 1};
+        }
+        return {std::string(name), ParseAmount(spec.substr(colon + 1), spec)};
+    }
+
+private:
+    static uint64_t ParseAmount(std::string_view text, std::string_view spec) {
+        size_t pos = 0;
+        uint64_t amount = 0;
+        while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos]))) {
+            amount = amount * 10 + static_cast<uint64_t>(text[pos] - '0');
+            ++pos;
+        }
+        if (pos == 0) {
+            throw std::invalid_argument("Resource spec without an amount: \"" + std::string(spec) + "\"");
+        }
+
+        std::string_view unit = text.substr(pos);
+        if (unit.empty() || unit == "B") {
+            return amount;
+        }
+        if (unit == "K" || unit == "KB") {
+            return amount << 10;
+        }
+        if (unit == "M" || unit == "MB") {
+            return amount << 20;
+        }
+        if (unit == "G" || unit == "GB") {
+            return amount << 30;
+        }
+        throw std::invalid_argument("Unknown unit in resource spec: \"" + std::string(spec) + "\"");
+    }
+
+private:
+    std::vector<ResourceRequirement> requirements_;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+template<typename T>
+struct ResultCodec;
+
+
+template<typename T>
+    requires std::is_trivially_copyable_v<T>
+struct ResultCodec<T> {
+    static size_t Size(const T&) {
+        return sizeof(T);
+    }
+
+    static void Write(const T& value, std::byte* out) {
+        std::memcpy(out, &value, sizeof(T));
+    }
+
+    static T Read(const std::byte* in, size_t) {
+        alignas(T) unsigned char buffer[sizeof(T)];
+        std::memcpy(buffer, in, sizeof(T));
+        return *std::launder(reinterpret_cast<T*>(buffer));
+    }
+};
+
+
+template<>
+struct ResultCodec<std::string> {
+    static size_t Size(const std::string& value) {
+        return value.size();
+    }
+
+    static void Write(const std::string& value, std::byte* out) {
+        std::memcpy(out, value.data(), value.size());
+    }
+
+    static std::string Read(const std::byte* in, size_t size) {
+        return std::string(reinterpret_cast<const char*>(in), size);
+    }
+};
+
+
+template<typename T>
+    requires (std::is_trivially_copyable_v<T> && std::default_initializable<T> && !std::is_same_v<T, bool>)
+struct ResultCodec<std::vector<T>> {
+    static size_t Size(const std::vector<T>& value) {
+        return value.size() * sizeof(T);
+    }
+
+    static void Write(const std::vector<T>& value, std::byte* out) {
+        std::memcpy(out, value.data(), value.size() * sizeof(T));
+    }
+
+    static std::vector<T> Read(const std::byte* in, size_t size) {
+        std::vector<T> value(size / sizeof(T));
+        std::memcpy(value.data(), in, value.size() * sizeof(T));
+        return value;
+    }
+};
@@ -4,8 +4,32 @@
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <span>
 #include <stdexcept>
+#include <chrono>
+#include <exception>
+#include <string>
+#include <utility>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <functional>
+#include <future>
+#include <algorithm>
 
+#include "cancellation.h"
+#include "channel.h"
+#include "io_loop.h"
+#include "process_task.h"
+#include "resources.h"
+#include "simulator.h"
+#include "result_codec.h"
+#include "spill_file.h"
+#include "task_errors.h"
+#include "stats.h"
+#include "topology.h"
 #include "hlprs_std/any.h"
 #include "hlprs_std/invoke.h"
 #include "hlprs_std/tuple.h"
@@ -15,13 +39,36 @@
 template<typename T>
 class FutureResult;
 
+template<typename T>
+class StreamResult;
+
+
+struct ExecutorOptions {
+    size_t threads = 0;
+    bool pin_workers = false;
+    bool numa_aware = false;
+    CpuTopology topology;
+};
+
 
 class TTaskScheduler {
 public:
     using SchedulerTaskId = size_t;
+    using Clock = CancellationToken::Clock;
+
+    enum class TaskState {
+        Pending,
+        Executed,
+        Cancelled,
+        Failed,
+    };
+
+    static constexpr size_t kNoNode = static_cast<size_t>(-1);
 
 public:
-    TTaskScheduler() = default;
+    TTaskScheduler() {
+        counters_.push_back(std::make_unique<WorkerCounters>());
+    }
 
     ~TTaskScheduler() {
         tasks_.clear();
@@ -35,6 +82,27 @@ public:
         : tasks_(std::move(other.tasks_))
         , task_id_(std::move(other.task_id_))
         , dependency_graph_(std::move(other.dependency_graph_)) 
+        , unresolved_refs_(std::move(other.unresolved_refs_))
+        , deadlines_(std::move(other.deadlines_))
+        , states_(std::move(other.states_))
+        , layout_(std::move(other.layout_))
+        , result_bytes_(std::move(other.result_bytes_))
+        , result_nodes_(std::move(other.result_nodes_))
+        , slots_(std::move(other.slots_))
+        , slot_tasks_(std::move(other.slot_tasks_))
+        , run_times_(std::move(other.run_times_))
+        , tasks_added_(other.tasks_added_.load())
+        , edges_(other.edges_.load())
+        , counters_(std::move(other.counters_))
+        , stream_tasks_(std::move(other.stream_tasks_))
+        , io_counters_(std::move(other.io_counters_))
+        , memory_budget_(other.memory_budget_)
+        , expected_bytes_(std::move(other.expected_bytes_))
+        , task_resources_(std::move(other.task_resources_))
+        , resource_capacity_(std::move(other.resource_capacity_))
+        , spill_counters_(std::move(other.spill_counters_))
+        , spill_file_(std::move(other.spill_file_))
+        , io_loop_(std::move(other.io_loop_))
     {}
 
     TTaskScheduler& operator=(TTaskScheduler&& other) noexcept {
@@ -45,36 +113,112 @@ public:
         tasks_ = std::move(other.tasks_);
         task_id_ = std::move(other.task_id_);
         dependency_graph_ = std::move(other.dependency_graph_);
+        unresolved_refs_ = std::move(other.unresolved_refs_);
+        deadlines_ = std::move(other.deadlines_);
+        states_ = std::move(other.states_);
+        layout_ = std::move(other.layout_);
+        result_bytes_ = std::move(other.result_bytes_);
+        result_nodes_ = std::move(other.result_nodes_);
+        slots_ = std::move(other.slots_);
+        slot_tasks_ = std::move(other.slot_tasks_);
+        run_times_ = std::move(other.run_times_);
+        tasks_added_ = other.tasks_added_.load();
+        edges_ = other.edges_.load();
+        counters_ = std::move(other.counters_);
+        stream_tasks_ = std::move(other.stream_tasks_);
+        io_counters_ = std::move(other.io_counters_);
+        memory_budget_ = other.memory_budget_;
+        expected_bytes_ = std::move(other.expected_bytes_);
+        task_resources_ = std::move(other.task_resources_);
+        resource_capacity_ = std::move(other.resource_capacity_);
+        spill_counters_ = std::move(other.spill_counters_);
+        spill_file_ = std::move(other.spill_file_);
+        io_loop_ = std::move(other.io_loop_);
         return *this;
     }
 
 public:
     template<typename CallableObj, typename... Args>
+        requires (!std::is_same_v<std::decay_t<CallableObj>, TaskResources>)
     auto add(CallableObj&& callable_object, Args&&... args) {
-        using TskImplmnttn = TaskImplementation<
-                                std::decay_t<CallableObj>,
+        DependencyList deps;
+        auto task_ptr = MakeTask(deps, std::forward<CallableObj>(callable_object), std::forward<Args>(args)...);
+        return RegisterTask(std::move(task_ptr), deps);
+    }
+
+    template<typename CallableObj, typename... Args>
+    auto add(TaskResources resources, CallableObj&& callable_object, Args&&... args) {
+        SchedulerTaskId new_id = add(std::forward<CallableObj>(callable_object), std::forward<Args>(args)...);
+        task_resources_[new_id] = std::move(resources);
+        return new_id;
+    }
+
+    template<typename CallableObj, typename... Args>
+        requires (!std::is_same_v<std::decay_t<CallableObj>, IsolationOptions>)
+    auto addIsolated(CallableObj&& callable_object, Args&&... args) {
+        return addIsolated(IsolationOptions{}, std::forward<CallableObj>(callable_object), std::forward<Args>(args)...);
+    }
+
+    template<typename CallableObj, typename... Args>
+    auto addIsolated(IsolationOptions options, CallableObj&& callable_object, Args&&... args) {
+        return add([callable = std::decay_t<CallableObj>(std::forward<CallableObj>(callable_object)),
+                    options = std::move(options)]
+                   (auto&&... resolved) mutable {
+            using Result = std::decay_t<decltype(dts::Invoke(callable, resolved...))>;
+            return RunInChildProcess<Result>([&] {
+                return dts::Invoke(callable, resolved...);
+            }, options);
+        }, std::forward<Args>(args)...);
+    }
+
+    SchedulerTaskId addAsyncRead(int fd, size_t max_bytes) {
+        if (!io_loop_) {
+            io_loop_ = std::make_unique<IoEventLoop>();
+        }
+        return RegisterTask(std::make_unique<AsyncReadTask>(io_loop_.get(), fd, max_bytes), {});
+    }
+
+    template<typename T, typename Producer, typename... Args>
+    auto addStream(size_t capacity, Producer&& producer, Args&&... args) {
+        using StrmImplmnttn = StreamTaskImplementation<
+                                T,
+                                std::decay_t<Producer>,
                                 std::decay_t<Args>...>;
 
-        SchedulerTaskId new_id = tasks_.size();
+        DependencyList deps;
+        AddDependencies(deps, args...);
 
-        auto task_ptr = std::make_unique<TskImplmnttn>(
+        auto task_ptr = std::make_unique<StrmImplmnttn>(
             this,
-            std::forward<CallableObj>(callable_object),
+            capacity,
+            std::forward<Producer>(producer),
             std::forward<Args>(args)...
         );
 
-        std::unordered_set<SchedulerTaskId> deps;
-        AddDependencies(deps, args...);
+        SchedulerTaskId new_id = RegisterTask(std::move(task_ptr), deps);
+        stream_tasks_.push_back(new_id);
+        return new_id;
+    }
 
-        dependency_graph_[new_id] = std::move(deps);
+    class GraphBuilder;
 
-        if (DetectCycle(new_id)) {
-            dependency_graph_.erase(new_id);
-            throw std::runtime_error("Detected cycle");
-        }
+    GraphBuilder builder() {
+        return GraphBuilder(*this);
+    }
 
-        tasks_.push_back(std::move(task_ptr));
-        return new_id;
+    void reserve(size_t tasks, size_t edges) {
+        tasks_.reserve(tasks);
+        states_.reserve(tasks);
+        deadlines_.reserve(tasks);
+        result_bytes_.reserve(tasks);
+        result_nodes_.reserve(tasks);
+        slots_.reserve(tasks);
+        slot_tasks_.reserve(tasks);
+        run_times_.reserve(tasks);
+        expected_bytes_.reserve(tasks);
+        task_resources_.reserve(tasks);
+        dependency_graph_.offsets.reserve(tasks + 1);
+        dependency_graph_.edges.reserve(edges);
     }
 
     template<typename T>
@@ -83,31 +227,733 @@ public:
     }
 
     template<typename T>
-    T getResult(SchedulerTaskId id) {
+    StreamResult<T> getStream(SchedulerTaskId id) {
+        return StreamResult<T>(this, id);
+    }
+
+    template<typename T>
+    Channel<T>& getChannel(SchedulerTaskId id, const CancellationToken& token = {}) {
+        return *getResult<std::shared_ptr<Channel<T>>>(id, token);
+    }
+
+    template<typename T>
+    T getResult(SchedulerTaskId id, const CancellationToken& token = {}) {
         
         static_assert(!std::is_void<T>::value, "Impossible to get void value");
 
         auto& task = *tasks_.at(id);
-        if (!task.executed) {
-            task.Execute();
+        RunTask(id, token);
+        if (StateOf(id) == TaskState::Cancelled) {
+            throw TaskCancelledError(id);
+        }
+        if (StateOf(id) == TaskState::Failed) {
+            std::rethrow_exception(task.error);
+        }
+        if (task.spilled.load(std::memory_order_acquire)) {
+            RestoreResult(id);
         }
         return dts::AnyCast<T>(task.getResult());
     }
 
-    void executeAll() {
-        for (auto& task : tasks_) {
-            if (!task->executed) {
-                task->Execute();
+    void executeAll(const CancellationToken& token = {}) {
+        ValidateResources();
+        if (isFrozen()) {
+            ExecuteFrozen(token);
+        } else {
+            for (SchedulerTaskId id = 0; id < tasks_.size(); ++id) {
+                RunTask(id, token);
+            }
+        }
+
+        FinishStreams();
+        ThrowIfFailed();
+    }
+
+    void executeParallel(const ExecutorOptions& options = {}, const CancellationToken& token = {}) {
+        if (tasks_.empty()) {
+            return;
+        }
+        ValidateResources();
+        if (!isFrozen()) {
+            freeze();
+        }
+
+        if (memory_budget_ && !spill_file_) {
+            spill_file_ = std::make_unique<SpillFile>();
+        }
+
+        ParallelExecution execution(*this, options, token);
+        execution.Run();
+
+        FinishStreams();
+        ThrowIfFailed();
+    }
+
+    void resetFailed() {
+        for (SchedulerTaskId id = 0; id < tasks_.size(); ++id) {
+            if (StateOf(id) == TaskState::Failed) {
+                StateOf(id) = TaskState::Pending;
+                tasks_[id]->error = nullptr;
+                tasks_[id]->getResult().Reset();
+            }
+        }
+    }
+
+    void freeze() {
+        const size_t count = tasks_.size();
+        std::vector<SchedulerTaskId> order;
+        order.reserve(count);
+
+        std::vector<bool> visited(count, false);
+        std::vector<std::pair<SchedulerTaskId, size_t>> stack;
+        for (SchedulerTaskId root = 0; root < count; ++root) {
+            if (visited[root]) {
+                continue;
+            }
+            visited[root] = true;
+            stack.emplace_back(root, 0);
+            while (!stack.empty()) {
+                auto& [node, next] = stack.back();
+                auto deps = Dependencies(node);
+                if (next == deps.size()) {
+                    order.push_back(node);
+                    stack.pop_back();
+                    continue;
+                }
+                SchedulerTaskId dep = deps[next++];
+                if (dep >= count) {
+                    throw std::out_of_range("Task depends on unknown task " + std::to_string(dep));
+                }
+                if (!visited[dep]) {
+                    visited[dep] = true;
+                    stack.emplace_back(dep, 0);
+                }
+            }
+        }
+
+        // Tasks that run back to back get neighbouring slots in the per-task state arrays.
+        std::vector<TaskState> states(count);
+        std::vector<size_t> result_bytes(count);
+        std::vector<size_t> result_nodes(count);
+        for (size_t pos = 0; pos < count; ++pos) {
+            size_t slot = slots_[order[pos]];
+            states[pos] = states_[slot];
+            result_bytes[pos] = result_bytes_[slot];
+            result_nodes[pos] = result_nodes_[slot];
+        }
+        states_ = std::move(states);
+        result_bytes_ = std::move(result_bytes);
+        result_nodes_ = std::move(result_nodes);
+        for (size_t pos = 0; pos < count; ++pos) {
+            slots_[order[pos]] = pos;
+        }
+        slot_tasks_ = std::move(order);
+
+        ExecutionLayout layout;
+        layout.dependency_offsets.reserve(count + 1);
+        layout.dependencies.reserve(dependency_graph_.edges.size());
+        layout.successor_offsets.assign(count + 1, 0);
+        for (size_t pos = 0; pos < count; ++pos) {
+            layout.dependency_offsets.push_back(layout.dependencies.size());
+            for (SchedulerTaskId dep : Dependencies(slot_tasks_[pos])) {
+                layout.dependencies.push_back(slots_[dep]);
+                ++layout.successor_offsets[slots_[dep] + 1];
+            }
+        }
+        layout.dependency_offsets.push_back(layout.dependencies.size());
+
+        for (size_t i = 0; i < count; ++i) {
+            layout.successor_offsets[i + 1] += layout.successor_offsets[i];
+        }
+        layout.successors.resize(layout.dependencies.size());
+        std::vector<size_t> cursor(layout.successor_offsets.begin(), layout.successor_offsets.end() - 1);
+        for (size_t pos = 0; pos < count; ++pos) {
+            for (size_t i = layout.dependency_offsets[pos]; i < layout.dependency_offsets[pos + 1]; ++i) {
+                layout.successors[cursor[layout.dependencies[i]]++] = pos;
             }
         }
+
+        layout_ = std::move(layout);
+    }
+
+    bool isFrozen() const {
+        return !tasks_.empty() && layout_.dependency_offsets.size() == tasks_.size() + 1;
+    }
+
+    void setDeadline(SchedulerTaskId id, Clock::time_point deadline) {
+        deadlines_.at(id) = deadline;
+    }
+
+    void setResourceCapacity(std::string_view spec) {
+        ResourceRequirement capacity = TaskResources::Parse(spec);
+        resource_capacity_[capacity.name] = capacity.amount;
+    }
+
+    void setMemoryBudget(size_t bytes) {
+        memory_budget_ = bytes;
+    }
+
+    void setExpectedResultBytes(SchedulerTaskId id, size_t bytes) {
+        expected_bytes_.at(id) = bytes;
+    }
+
+    bool isSpilled(SchedulerTaskId id) const {
+        return tasks_.at(id)->spilled.load(std::memory_order_acquire);
+    }
+
+    TaskState state(SchedulerTaskId id) const {
+        return states_[slots_.at(id)];
+    }
+
+    size_t resultNode(SchedulerTaskId id) const {
+        return result_nodes_[slots_.at(id)];
+    }
+
+    Clock::duration runTime(SchedulerTaskId id) const {
+        return run_times_.at(id);
+    }
+
+    ScheduleSimulator simulator() const {
+        std::vector<std::vector<SchedulerTaskId>> dependencies(tasks_.size());
+        std::vector<std::chrono::nanoseconds> costs(tasks_.size());
+        for (SchedulerTaskId id = 0; id < tasks_.size(); ++id) {
+            const auto& deps = Dependencies(id);
+            dependencies[id].assign(deps.begin(), deps.end());
+            costs[id] = run_times_[id];
+        }
+        return ScheduleSimulator(std::move(dependencies), std::move(costs));
+    }
+
+    SchedulerStats stats() const {
+        SchedulerStats snapshot;
+        snapshot.tasks_added = tasks_added_.load(std::memory_order_relaxed);
+        snapshot.edges = edges_.load(std::memory_order_relaxed);
+
+        std::lock_guard lock(counters_mutex_);
+        snapshot.workers.resize(counters_.size());
+        for (size_t w = 0; w < counters_.size(); ++w) {
+            counters_[w]->Collect(snapshot, snapshot.workers[w]);
+        }
+        WorkerStats io_loop;
+        io_counters_->Collect(snapshot, io_loop);
+        std::lock_guard spill_lock(spill_mutex_);
+        WorkerStats spilling;
+        spill_counters_->Collect(snapshot, spilling);
+        return snapshot;
     }
 
 private:
+    using DependencyList = std::vector<SchedulerTaskId>;
+
+    struct DependencyGraph {
+        std::vector<size_t> offsets{0};
+        std::vector<SchedulerTaskId> edges;
+    };
+
+    struct SpillOps {
+        std::string (*encode)(dts::Any&);
+        void (*decode)(dts::Any&, const std::string&);
+    };
+
+    // Indexed by slot: a task's position in the frozen execution order.
+    struct ExecutionLayout {
+        std::vector<size_t> dependency_offsets;
+        std::vector<size_t> dependencies;
+        std::vector<size_t> successor_offsets;
+        std::vector<size_t> successors;
+    };
+
+    class ParallelExecution {
+    public:
+        ParallelExecution(TTaskScheduler& owner, const ExecutorOptions& options, const CancellationToken& token)
+            : owner_(owner)
+            , token_(token)
+            , pin_workers_(options.pin_workers)
+            , topology_(options.topology.nodes().empty() ? CpuTopology::Detect() : options.topology)
+            , workers_(options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency()))
+            , remaining_(std::make_unique<std::atomic<size_t>[]>(owner.tasks_.size()))
+            , ready_at_(std::make_unique<Clock::time_point[]>(owner.tasks_.size()))
+            , budget_(static_cast<int64_t>(owner.memory_budget_))
+        {
+            owner_.EnsureCounters(workers_.size());
+            for (size_t w = 0; w < workers_.size(); ++w) {
+                workers_[w].counters = owner_.counters_[w].get();
+            }
+
+            const auto& nodes = topology_.nodes();
+            node_count_ = options.numa_aware ? nodes.size() : 1;
+            node_cursors_ = std::make_unique<std::atomic<size_t>[]>(node_count_);
+
+            std::vector<size_t> all_cpus;
+            for (const auto& node : nodes) {
+                all_cpus.insert(all_cpus.end(), node.cpus.begin(), node.cpus.end());
+            }
+
+            for (size_t w = 0; w < workers_.size(); ++w) {
+                if (options.numa_aware) {
+                    workers_[w].node = w % node_count_;
+                    const auto& cpus = nodes[workers_[w].node].cpus;
+                    workers_[w].cpu = cpus[(w / node_count_) % cpus.size()];
+                } else {
+                    workers_[w].node = 0;
+                    workers_[w].cpu = all_cpus[w % all_cpus.size()];
+                }
+            }
+
+            std::vector<size_t> worker_nodes;
+            for (const auto& worker : workers_) {
+                worker_nodes.push_back(worker.node);
+            }
+            for (size_t w = 0; w < workers_.size(); ++w) {
+                workers_[w].steal_order = CpuTopology::StealOrder(worker_nodes, w);
+            }
+        }
+
+    public:
+        void Run() {
+            const auto& layout = owner_.layout_;
+            const auto start = Clock::now();
+            size_t next_worker = 0;
+            for (size_t pos = 0; pos < owner_.slot_tasks_.size(); ++pos) {
+                SchedulerTaskId id = owner_.slot_tasks_[pos];
+                if (owner_.states_[pos] != TaskState::Pending) {
+                    continue;
+                }
+
+                size_t pending = 0;
+                for (size_t i = layout.dependency_offsets[pos]; i < layout.dependency_offsets[pos + 1]; ++i) {
+                    if (owner_.states_[layout.dependencies[i]] == TaskState::Pending) {
+                        ++pending;
+                    }
+                }
+                remaining_[pos].store(pending, std::memory_order_relaxed);
+                outstanding_.fetch_add(1, std::memory_order_relaxed);
+                if (pending == 0) {
+                    ready_at_[id] = start;
+                    Push(next_worker++ % workers_.size(), id, *workers_[0].counters);
+                }
+            }
+
+            if (outstanding_.load() == 0) {
+                return;
+            }
+            if (budget_) {
+                InitBudget();
+            }
+            if (!owner_.resource_capacity_.empty()) {
+                InitResources();
+            }
+
+            std::vector<std::jthread> threads;
+            threads.reserve(workers_.size());
+            for (size_t w = 0; w < workers_.size(); ++w) {
+                threads.emplace_back([this, w] { WorkerLoop(w); });
+            }
+        }
+
+    private:
+        struct Worker {
+            std::mutex mutex;
+            std::deque<SchedulerTaskId> queue;
+            size_t node = 0;
+            size_t cpu = 0;
+            std::vector<size_t> steal_order;
+            WorkerCounters* counters = nullptr;
+        };
+
+    private:
+        void WorkerLoop(size_t w) {
+            if (pin_workers_) {
+                CpuTopology::PinCurrentThread(workers_[w].cpu);
+            }
+
+            while (true) {
+                SchedulerTaskId id;
+                if (TryPop(w, id)) {
+                    ProcessTask(w, id);
+                    continue;
+                }
+
+                std::unique_lock lock(idle_mutex_);
+                if (Drained()) {
+                    return;
+                }
+                const auto idle_start = Clock::now();
+                idle_cv_.wait(lock, [this] {
+                    return queued_.load() > 0 || Drained();
+                });
+                workers_[w].counters->AddIdle(Clock::now() - idle_start);
+            }
+        }
+
+        // An async completion runs on the event loop thread and still touches this object after the last
+        // task is done, so workers (and the executor with them) only leave once it has fully returned.
+        bool Drained() const {
+            return outstanding_.load() == 0 && async_in_flight_ == 0;
+        }
+
+        bool TryPop(size_t w, SchedulerTaskId& id) {
+            {
+                std::lock_guard lock(workers_[w].mutex);
+                if (!workers_[w].queue.empty()) {
+                    id = workers_[w].queue.back();
+                    workers_[w].queue.pop_back();
+                    queued_.fetch_sub(1);
+                    return true;
+                }
+            }
+
+            for (size_t victim : workers_[w].steal_order) {
+                std::lock_guard lock(workers_[victim].mutex);
+                bool stolen = !workers_[victim].queue.empty();
+                workers_[w].counters->AddStealAttempt(stolen);
+                if (stolen) {
+                    id = workers_[victim].queue.front();
+                    workers_[victim].queue.pop_front();
+                    queued_.fetch_sub(1);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void Push(size_t w, SchedulerTaskId id, WorkerCounters& counters) {
+            {
+                std::lock_guard lock(workers_[w].mutex);
+                workers_[w].queue.push_back(id);
+            }
+            counters.ObserveQueueDepth(queued_.fetch_add(1) + 1);
+            {
+                std::lock_guard lock(idle_mutex_);
+            }
+            idle_cv_.notify_one();
+        }
+
+        void ProcessTask(size_t w, SchedulerTaskId id) {
+            const auto& layout = owner_.layout_;
+            size_t pos = owner_.slots_[id];
+
+            bool skipped = false;
+            for (size_t i = layout.dependency_offsets[pos]; i < layout.dependency_offsets[pos + 1]; ++i) {
+                if (owner_.InheritDependencyState(pos, layout.dependencies[i])) {
+                    skipped = true;
+                    break;
+                }
+            }
+            if (!skipped) {
+                if (budget_ && HoldBack(id)) {
+                    return;
+                }
+                if (constrained_ && !demands_[id].empty() && !AcquireResources(id)) {
+                    if (budget_) {
+                        Withdraw(id);
+                    }
+                    return;
+                }
+            }
+
+            workers_[w].counters->AddSchedulingLatency(Clock::now() - ready_at_[id]);
+            owner_.result_nodes_[pos] = workers_[w].node;
+            if (!skipped) {
+                if (owner_.tasks_[id]->IsAsync()) {
+                    {
+                        std::lock_guard lock(idle_mutex_);
+                        ++async_in_flight_;
+                    }
+                    bool submitted = owner_.LaunchAsyncTask(id, token_, [this, w, id] {
+                        Complete(w, id, *owner_.io_counters_, true);
+                        std::lock_guard lock(idle_mutex_);
+                        --async_in_flight_;
+                        idle_cv_.notify_all();
+                    });
+                    if (submitted) {
+                        return;
+                    }
+                    std::lock_guard lock(idle_mutex_);
+                    --async_in_flight_;
+                } else {
+                    owner_.LaunchTask(id, token_, *workers_[w].counters);
+                }
+            }
+
+            Complete(w, id, *workers_[w].counters, !skipped);
+        }
+
+        void Complete(size_t w, SchedulerTaskId id, WorkerCounters& counters, bool admitted) {
+            if (budget_) {
+                Settle(w, id, counters, admitted);
+            }
+            if (constrained_ && granted_[id]) {
+                ReleaseResources(w, id, counters);
+            }
+
+            const auto& layout = owner_.layout_;
+            size_t pos = owner_.slots_[id];
+            for (size_t i = layout.successor_offsets[pos]; i < layout.successor_offsets[pos + 1]; ++i) {
+                size_t next = layout.successors[i];
+                if (owner_.states_[next] != TaskState::Pending) {
+                    continue;
+                }
+                if (remaining_[next].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    Dispatch(w, owner_.slot_tasks_[next], counters);
+                }
+            }
+
+            if (outstanding_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard lock(idle_mutex_);
+                idle_cv_.notify_all();
+            }
+        }
+
+        void Dispatch(size_t w, SchedulerTaskId id, WorkerCounters& counters) {
+            if (node_count_ > 1) {
+                size_t node = PreferredNode(id);
+                if (node != workers_[w].node) {
+                    size_t offset = node_cursors_[node].fetch_add(1, std::memory_order_relaxed);
+                    size_t per_node = (workers_.size() + node_count_ - 1 - node) / node_count_;
+                    if (per_node > 0) {
+                        ready_at_[id] = Clock::now();
+                        Push(node + (offset % per_node) * node_count_, id, counters);
+                        return;
+                    }
+                }
+            }
+            ready_at_[id] = Clock::now();
+            Push(w, id, counters);
+        }
+
+        void InitResources() {
+            std::unordered_map<std::string, size_t> slots;
+            for (const auto& [name, capacity] : owner_.resource_capacity_) {
+                slots[name] = available_.size();
+                available_.push_back(capacity);
+            }
+
+            demands_.resize(owner_.tasks_.size());
+            for (SchedulerTaskId id = 0; id < owner_.tasks_.size(); ++id) {
+                for (const auto& requirement : owner_.task_resources_[id].requirements()) {
+                    demands_[id].emplace_back(slots.at(requirement.name), requirement.amount);
+                    constrained_ = true;
+                }
+            }
+            granted_ = std::make_unique<bool[]>(owner_.tasks_.size());
+        }
+
+        bool TakeResources(std::vector<uint64_t>& pool, SchedulerTaskId id) const {
+            for (auto [slot, amount] : demands_[id]) {
+                if (pool[slot] < amount) {
+                    return false;
+                }
+            }
+            for (auto [slot, amount] : demands_[id]) {
+                pool[slot] -= amount;
+            }
+            return true;
+        }
+
+        bool AcquireResources(SchedulerTaskId id) {
+            std::lock_guard lock(resource_mutex_);
+            if (!TakeResources(available_, id)) {
+                blocked_.push_back(id);
+                return false;
+            }
+            granted_[id] = true;
+            return true;
+        }
+
+        // Unblocked tasks are only re-queued, not granted: they acquire again right before launch, so a task
+        // that ends up skipped or held back by the memory budget never sits on pool units.
+        void ReleaseResources(size_t w, SchedulerTaskId id, WorkerCounters& counters) {
+            std::vector<SchedulerTaskId> unblocked;
+            {
+                std::lock_guard lock(resource_mutex_);
+                for (auto [slot, amount] : demands_[id]) {
+                    available_[slot] += amount;
+                }
+                granted_[id] = false;
+
+                std::vector<uint64_t> pool = available_;
+                for (auto it = blocked_.begin(); it != blocked_.end();) {
+                    if (TakeResources(pool, *it)) {
+                        unblocked.push_back(*it);
+                        it = blocked_.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+
+            for (SchedulerTaskId next : unblocked) {
+                Push(w, next, counters);
+            }
+        }
+
+        void InitBudget() {
+            const auto& layout = owner_.layout_;
+            consumers_ = std::make_unique<size_t[]>(owner_.tasks_.size());
+            for (size_t pos = 0; pos < owner_.slot_tasks_.size(); ++pos) {
+                SchedulerTaskId id = owner_.slot_tasks_[pos];
+                for (size_t i = layout.successor_offsets[pos]; i < layout.successor_offsets[pos + 1]; ++i) {
+                    if (owner_.states_[layout.successors[i]] == TaskState::Pending) {
+                        ++consumers_[pos];
+                    }
+                }
+                if (owner_.states_[pos] == TaskState::Executed && !owner_.tasks_[id]->spilled.load()) {
+                    live_bytes_ += owner_.result_bytes_[pos];
+                    if (consumers_[pos] == 0) {
+                        cold_.push_back(id);
+                    }
+                }
+            }
+        }
+
+        bool Fits(SchedulerTaskId id, int64_t extra) const {
+            return live_bytes_ + reserved_bytes_ + extra + static_cast<int64_t>(owner_.expected_bytes_[id]) <= budget_;
+        }
+
+        bool HoldBack(SchedulerTaskId id) {
+            std::lock_guard lock(budget_mutex_);
+            if (running_ > 0 && !Fits(id, 0)) {
+                held_.push_back(id);
+                return true;
+            }
+            ++running_;
+            reserved_bytes_ += owner_.expected_bytes_[id];
+            return false;
+        }
+
+        void Withdraw(SchedulerTaskId id) {
+            std::lock_guard lock(budget_mutex_);
+            --running_;
+            reserved_bytes_ -= owner_.expected_bytes_[id];
+        }
+
+        void Settle(size_t w, SchedulerTaskId id, WorkerCounters& counters, bool admitted) {
+            const auto& layout = owner_.layout_;
+            size_t pos = owner_.slots_[id];
+            std::vector<SchedulerTaskId> released;
+            std::vector<SchedulerTaskId> victims;
+            {
+                std::lock_guard lock(budget_mutex_);
+                if (admitted) {
+                    --running_;
+                    reserved_bytes_ -= owner_.expected_bytes_[id];
+                }
+                if (owner_.states_[pos] == TaskState::Executed) {
+                    live_bytes_ += owner_.result_bytes_[pos];
+                    if (consumers_[pos] == 0) {
+                        cold_.push_back(id);
+                    }
+                }
+                for (size_t i = layout.dependency_offsets[pos]; i < layout.dependency_offsets[pos + 1]; ++i) {
+                    size_t dep = layout.dependencies[i];
+                    if (--consumers_[dep] == 0 && owner_.states_[dep] == TaskState::Executed) {
+                        cold_.push_back(owner_.slot_tasks_[dep]);
+                    }
+                }
+
+                while (live_bytes_ > budget_ && !cold_.empty()) {
+                    SchedulerTaskId cold = cold_.front();
+                    cold_.pop_front();
+                    if (owner_.IsSpillable(cold)) {
+                        live_bytes_ -= owner_.result_bytes_[owner_.slots_[cold]];
+                        victims.push_back(cold);
+                    }
+                }
+
+                int64_t released_bytes = 0;
+                while (!held_.empty()) {
+                    SchedulerTaskId next = held_.front();
+                    bool idle = running_ == 0 && released.empty();
+                    if (!idle && !Fits(next, released_bytes)) {
+                        break;
+                    }
+                    held_.pop_front();
+                    released_bytes += owner_.expected_bytes_[next];
+                    released.push_back(next);
+                }
+            }
+
+            for (SchedulerTaskId cold : victims) {
+                if (!owner_.SpillResult(cold)) {
+                    std::lock_guard lock(budget_mutex_);
+                    live_bytes_ += owner_.result_bytes_[owner_.slots_[cold]];
+                }
+            }
+            for (SchedulerTaskId next : released) {
+                Push(w, next, counters);
+            }
+        }
+
+        size_t PreferredNode(SchedulerTaskId id) const {
+            const auto& layout = owner_.layout_;
+            size_t pos = owner_.slots_[id];
+
+            std::vector<size_t> bytes(node_count_, 0);
+            for (size_t i = layout.dependency_offsets[pos]; i < layout.dependency_offsets[pos + 1]; ++i) {
+                size_t dep = layout.dependencies[i];
+                size_t node = owner_.result_nodes_[dep];
+                if (node < node_count_) {
+                    bytes[node] += owner_.result_bytes_[dep];
+                }
+            }
+            return std::max_element(bytes.begin(), bytes.end()) - bytes.begin();
+        }
+
+    private:
+        TTaskScheduler& owner_;
+        const CancellationToken& token_;
+        bool pin_workers_;
+        CpuTopology topology_;
+        std::vector<Worker> workers_;
+        size_t node_count_ = 1;
+        std::unique_ptr<std::atomic<size_t>[]> node_cursors_;
+        std::unique_ptr<std::atomic<size_t>[]> remaining_;
+        std::unique_ptr<Clock::time_point[]> ready_at_;
+        std::atomic<size_t> outstanding_ = 0;
+        std::atomic<size_t> queued_ = 0;
+        std::mutex idle_mutex_;
+        std::condition_variable idle_cv_;
+        size_t async_in_flight_ = 0;
+        const int64_t budget_;
+        std::mutex budget_mutex_;
+        std::unique_ptr<size_t[]> consumers_;
+        std::deque<SchedulerTaskId> held_;
+        std::deque<SchedulerTaskId> cold_;
+        size_t running_ = 0;
+        int64_t live_bytes_ = 0;
+        int64_t reserved_bytes_ = 0;
+        bool constrained_ = false;
+        std::mutex resource_mutex_;
+        std::vector<uint64_t> available_;
+        std::vector<std::vector<std::pair<size_t, uint64_t>>> demands_;
+        std::unique_ptr<bool[]> granted_;
+        std::deque<SchedulerTaskId> blocked_;
+    };
+
     class Task {
     public:
-        bool executed = false;
+        std::exception_ptr error;
+        SchedulerTaskId error_source = 0;
+        const SpillOps* spill_ops = nullptr;
+        std::atomic<bool> spilled = false;
+        SpillFile::Extent spill_extent;
         virtual void Execute() = 0;
         virtual dts::Any& getResult() = 0;
+        virtual size_t ResultBytes() const = 0;
+        virtual std::exception_ptr Finish() { return nullptr; }
+        virtual bool Truncated() const { return false; }
+        virtual bool IsAsync() const { return false; }
+        virtual void Submit(const CancellationToken&, Clock::time_point,
+                            std::function<void(std::exception_ptr, bool)> done) {
+            try {
+                Execute();
+            } catch (...) {
+                done(std::current_exception(), false);
+                return;
+            }
+            done(nullptr, false);
+        }
         virtual ~Task() = default;
     };
 
@@ -117,36 +963,648 @@ private:
         TaskImplementation(TTaskScheduler* owner, Callable func, Args... args)
             : scheduler_ptr_(owner)
             , function_(std::move(func))
-            , task_arguments_(dts::MakeTuple(std::move(args)...)) {}
+            , task_arguments_(std::move(args)...) {}
     
     public:
         void Execute() override {
-            if (this->executed) return;
+            auto result = dts::ApplyTransformed(function_, task_arguments_, [this](auto&& tuple_arg) -> decltype(auto) {
+                return scheduler_ptr_->ResolveArg(std::forward<decltype(tuple_arg)>(tuple_arg));
+            });
+            this->result_bytes_ = ApproximateBytes(result);
+            this->spill_ops = SpillOpsFor<decltype(result)>();
+            this->task_result_.template Emplace<decltype(result)>(std::move(result));
+        }
+
+        dts::Any& getResult() override {
+            return task_result_;
+        }
+
+        size_t ResultBytes() const override {
+            return result_bytes_;
+        }
+
+    private:
+        TTaskScheduler* scheduler_ptr_;
+        Callable function_;
+        dts::Tuple<Args...> task_arguments_;
+        dts::Any task_result_;
+        size_t result_bytes_ = 0;
+    };
+
+    class AsyncReadTask : public Task {
+    public:
+        AsyncReadTask(IoEventLoop* loop, int fd, size_t max_bytes)
+            : loop_(loop)
+            , fd_(fd)
+            , max_bytes_(max_bytes) {}
+
+    public:
+        void Execute() override {
+            std::promise<std::exception_ptr> finished;
+            auto outcome = finished.get_future();
+            Submit({}, Clock::time_point::max(), [&finished](std::exception_ptr read_error, bool) {
+                finished.set_value(read_error);
+            });
+            if (auto read_error = outcome.get()) {
+                std::rethrow_exception(read_error);
+            }
+        }
 
-            dts::Apply([this](auto&&... tuple_args) {
-                auto args = dts::MakeTuple(
-                    scheduler_ptr_->ResolveArg(
-                        std::forward<decltype(tuple_args)>(tuple_args)
-                    )...
-                );
-                this->task_result_ = dts::Apply(function_, std::move(args));
-            }, task_arguments_);
+        bool IsAsync() const override {
+            return true;
+        }
 
-            this->executed = true;
+        void Submit(const CancellationToken& token, Clock::time_point deadline,
+                    std::function<void(std::exception_ptr, bool)> done) override {
+            buffer_.clear();
+            read_error_ = nullptr;
+            loop_->watch(fd_, IoEventLoop::kReadable, [this] {
+                return ReadAvailable();
+            }, [this, done = std::move(done)](bool cancelled) {
+                if (cancelled) {
+                    buffer_ = std::string();
+                    done(nullptr, true);
+                    return;
+                }
+                if (!read_error_) {
+                    result_bytes_ = ApproximateBytes(buffer_);
+                    task_result_.Emplace<std::string>(std::move(buffer_));
+                    buffer_ = std::string();
+                    spill_ops = SpillOpsFor<std::string>();
+                }
+                done(read_error_, false);
+            }, token, deadline);
         }
 
         dts::Any& getResult() override {
             return task_result_;
         }
 
+        size_t ResultBytes() const override {
+            return result_bytes_;
+        }
+
+    private:
+        bool ReadAvailable() {
+            char chunk[16 * 1024];
+            while (buffer_.size() < max_bytes_) {
+                size_t want = std::min(sizeof(chunk), max_bytes_ - buffer_.size());
+                ssize_t count = ::read(fd_, chunk, want);
+                if (count > 0) {
+                    buffer_.append(chunk, static_cast<size_t>(count));
+                    continue;
+                }
+                if (count == 0) {
+                    return true;
+                }
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return false;
+                }
+                read_error_ = std::make_exception_ptr(
+                    std::system_error(errno, std::generic_category(), "read"));
+                return true;
+            }
+            return true;
+        }
+
+    private:
+        IoEventLoop* loop_;
+        int fd_;
+        size_t max_bytes_;
+        std::string buffer_;
+        std::exception_ptr read_error_;
+        size_t result_bytes_ = 0;
+        dts::Any task_result_;
+    };
+
+    template<typename T, typename Producer, typename... Args>
+    class StreamTaskImplementation : public Task {
+    public:
+        StreamTaskImplementation(TTaskScheduler* owner, size_t capacity, Producer producer, Args... args)
+            : scheduler_ptr_(owner)
+            , capacity_(capacity)
+            , producer_(std::move(producer))
+            , task_arguments_(std::move(args)...) {}
+
+        ~StreamTaskImplementation() override {
+            Finish();
+        }
+
+    public:
+        void Execute() override {
+            Finish();
+            channel_ = std::make_shared<Channel<T>>(capacity_);
+            producer_error_ = nullptr;
+            task_result_ = channel_;
+
+            thread_ = std::thread([this] {
+                try {
+                    dts::Apply([this](auto&&... tuple_args) {
+                        dts::Invoke(producer_, *channel_,
+                            scheduler_ptr_->ResolveArg(
+                                std::forward<decltype(tuple_args)>(tuple_args)
+                            )...
+                        );
+                    }, task_arguments_);
+                    channel_->close();
+                } catch (...) {
+                    producer_error_ = std::current_exception();
+                    channel_->close(producer_error_);
+                }
+            });
+
+            channel_->waitReady();
+        }
+
+        dts::Any& getResult() override {
+            return task_result_;
+        }
+
+        size_t ResultBytes() const override {
+            return sizeof(Channel<T>) + capacity_ * sizeof(T);
+        }
+
+        std::exception_ptr Finish() override {
+            if (!thread_.joinable()) {
+                return nullptr;
+            }
+            channel_->close();
+            thread_.join();
+            return producer_error_;
+        }
+
+        bool Truncated() const override {
+            return channel_ && channel_->dropped();
+        }
+
     private:
         TTaskScheduler* scheduler_ptr_;
-        Callable function_;
+        size_t capacity_;
+        Producer producer_;
         dts::Tuple<Args...> task_arguments_;
         dts::Any task_result_;
+        std::shared_ptr<Channel<T>> channel_;
+        std::exception_ptr producer_error_;
+        std::thread thread_;
+    };
+
+public:
+    class GraphBuilder {
+    public:
+        explicit GraphBuilder(TTaskScheduler& owner)
+            : owner_(owner)
+            , base_(owner.tasks_.size())
+        {}
+
+    public:
+        template<typename CallableObj, typename... Args>
+        SchedulerTaskId add(CallableObj&& callable_object, Args&&... args) {
+            deps_.clear();
+            auto task_ptr = owner_.MakeTask(deps_, std::forward<CallableObj>(callable_object), std::forward<Args>(args)...);
+            edges_.insert(edges_.end(), deps_.begin(), deps_.end());
+            tasks_.push_back(std::move(task_ptr));
+            offsets_.push_back(edges_.size());
+            return base_ + tasks_.size() - 1;
+        }
+
+        template<typename T>
+        FutureResult<T> getFutureResult(SchedulerTaskId id) {
+            return owner_.getFutureResult<T>(id);
+        }
+
+        void reserve(size_t tasks, size_t edges) {
+            tasks_.reserve(tasks);
+            offsets_.reserve(tasks + 1);
+            edges_.reserve(edges);
+        }
+
+        size_t size() const {
+            return tasks_.size();
+        }
+
+        void commit() {
+            if (owner_.tasks_.size() != base_) {
+                throw std::logic_error("Scheduler changed while the graph builder was open");
+            }
+            owner_.CommitTasks(tasks_, offsets_, edges_);
+            tasks_.clear();
+            offsets_.assign(1, 0);
+            edges_.clear();
+            base_ = owner_.tasks_.size();
+        }
+
+    private:
+        TTaskScheduler& owner_;
+        SchedulerTaskId base_;
+        std::vector<std::unique_ptr<Task>> tasks_;
+        std::vector<size_t> offsets_{0};
+        std::vector<SchedulerTaskId> edges_;
+        DependencyList deps_;
     };
 
 private:
+    SchedulerTaskId RegisterTask(std::unique_ptr<Task> task_ptr, const DependencyList& deps) {
+        SchedulerTaskId new_id = tasks_.size();
+        auto& graph = dependency_graph_;
+        const size_t edges_before = graph.edges.size();
+
+        graph.edges.insert(graph.edges.end(), deps.begin(), deps.end());
+        graph.offsets.push_back(graph.edges.size());
+
+        // Only a task that an earlier task already refers to (or one depending on itself) can close a cycle.
+        bool referenced = !unresolved_refs_.empty() && unresolved_refs_.count(new_id);
+        bool self_loop = std::find(deps.begin(), deps.end(), new_id) != deps.end();
+        if ((referenced || self_loop) && DetectCycle(new_id)) {
+            graph.edges.resize(edges_before);
+            graph.offsets.pop_back();
+            throw std::runtime_error("Detected cycle");
+        }
+        if (referenced) {
+            unresolved_refs_.erase(new_id);
+        }
+        for (SchedulerTaskId dep : deps) {
+            if (dep > new_id) {
+                unresolved_refs_.insert(dep);
+            }
+        }
+
+        AppendTask(std::move(task_ptr));
+        layout_ = ExecutionLayout{};
+        tasks_added_.fetch_add(1, std::memory_order_relaxed);
+        edges_.fetch_add(deps.size(), std::memory_order_relaxed);
+        return new_id;
+    }
+
+    void AppendTask(std::unique_ptr<Task> task_ptr) {
+        tasks_.push_back(std::move(task_ptr));
+        states_.push_back(TaskState::Pending);
+        deadlines_.push_back(Clock::time_point::max());
+        result_bytes_.push_back(0);
+        result_nodes_.push_back(kNoNode);
+        slots_.push_back(slot_tasks_.size());
+        slot_tasks_.push_back(tasks_.size() - 1);
+        run_times_.push_back(Clock::duration::zero());
+        expected_bytes_.push_back(0);
+        task_resources_.emplace_back();
+    }
+
+    void CommitTasks(std::vector<std::unique_ptr<Task>>& tasks, const std::vector<size_t>& offsets,
+                     const std::vector<SchedulerTaskId>& edges) {
+        const size_t base = tasks_.size();
+        const size_t end = base + tasks.size();
+        size_t from = base;
+        for (SchedulerTaskId id : unresolved_refs_) {
+            if (id >= base && id < end) {
+                from = 0;
+            }
+        }
+
+        auto staged_deps = [&](SchedulerTaskId id) {
+            if (id < base) {
+                return Dependencies(id);
+            }
+            size_t index = id - base;
+            return std::span<const SchedulerTaskId>(edges.data() + offsets[index], offsets[index + 1] - offsets[index]);
+        };
+
+        for (SchedulerTaskId dep : edges) {
+            if (dep >= end) {
+                throw std::out_of_range("Task depends on unknown task " + std::to_string(dep));
+            }
+        }
+
+        std::vector<size_t> indegree(end - from, 0);
+        std::vector<size_t> successor_offsets(end - from + 1, 0);
+        for (SchedulerTaskId id = from; id < end; ++id) {
+            for (SchedulerTaskId dep : staged_deps(id)) {
+                if (dep >= from && dep < end) {
+                    ++indegree[id - from];
+                    ++successor_offsets[dep - from + 1];
+                }
+            }
+        }
+        for (size_t i = 0; i + 1 < successor_offsets.size(); ++i) {
+            successor_offsets[i + 1] += successor_offsets[i];
+        }
+        std::vector<SchedulerTaskId> successors(successor_offsets.back());
+        std::vector<size_t> cursor(successor_offsets.begin(), successor_offsets.end() - 1);
+        std::vector<SchedulerTaskId> ready;
+        ready.reserve(end - from);
+        for (SchedulerTaskId id = from; id < end; ++id) {
+            for (SchedulerTaskId dep : staged_deps(id)) {
+                if (dep >= from && dep < end) {
+                    successors[cursor[dep - from]++] = id;
+                }
+            }
+            if (indegree[id - from] == 0) {
+                ready.push_back(id);
+            }
+        }
+        for (size_t i = 0; i < ready.size(); ++i) {
+            SchedulerTaskId id = ready[i];
+            for (size_t j = successor_offsets[id - from]; j < successor_offsets[id - from + 1]; ++j) {
+                if (--indegree[successors[j] - from] == 0) {
+                    ready.push_back(successors[j]);
+                }
+            }
+        }
+        if (ready.size() != end - from) {
+            throw std::runtime_error("Detected cycle");
+        }
+
+        const size_t edge_count = dependency_graph_.edges.size() + edges.size();
+        if (end > tasks_.capacity() || edge_count > dependency_graph_.edges.capacity()) {
+            reserve(std::max(end, 2 * tasks_.capacity()),
+                    std::max(edge_count, 2 * dependency_graph_.edges.capacity()));
+        }
+        for (size_t index = 0; index < tasks.size(); ++index) {
+            AppendTask(std::move(tasks[index]));
+            dependency_graph_.offsets.push_back(dependency_graph_.offsets.back() + offsets[index + 1] - offsets[index]);
+        }
+        dependency_graph_.edges.insert(dependency_graph_.edges.end(), edges.begin(), edges.end());
+        std::erase_if(unresolved_refs_, [&](SchedulerTaskId id) { return id >= base && id < end; });
+        layout_ = ExecutionLayout{};
+        tasks_added_.fetch_add(tasks.size(), std::memory_order_relaxed);
+        edges_.fetch_add(edges.size(), std::memory_order_relaxed);
+    }
+
+    void FinishStreams() {
+        for (SchedulerTaskId id : stream_tasks_) {
+            std::exception_ptr error = tasks_[id]->Finish();
+            if (StateOf(id) != TaskState::Executed) {
+                continue;
+            }
+            if (error) {
+                StateOf(id) = TaskState::Failed;
+                tasks_[id]->error = error;
+                tasks_[id]->error_source = id;
+            } else if (tasks_[id]->Truncated()) {
+                StateOf(id) = TaskState::Cancelled;
+            }
+        }
+    }
+
+    void RunTask(SchedulerTaskId id, const CancellationToken& token) {
+        tasks_.at(id);
+        if (StateOf(id) != TaskState::Pending) {
+            return;
+        }
+
+        if (IsExpired(id, token)) {
+            StateOf(id) = TaskState::Cancelled;
+            return;
+        }
+
+        for (SchedulerTaskId dep : Dependencies(id)) {
+            RunTask(dep, token);
+            if (InheritDependencyState(slots_[id], slots_[dep])) {
+                return;
+            }
+        }
+
+        LaunchTask(id, token, *counters_.front());
+    }
+
+    void ThrowIfFailed() const {
+        std::vector<TaskExecutionError::Failure> failures;
+        std::vector<SchedulerTaskId> skipped;
+        for (SchedulerTaskId id = 0; id < tasks_.size(); ++id) {
+            if (StateOf(id) != TaskState::Failed) {
+                continue;
+            }
+            auto& task = *tasks_[id];
+            if (task.error_source == id) {
+                failures.push_back({id, task.error});
+            } else {
+                skipped.push_back(id);
+            }
+        }
+
+        if (!failures.empty()) {
+            throw TaskExecutionError(std::move(failures), std::move(skipped));
+        }
+    }
+
+    void ExecuteFrozen(const CancellationToken& token) {
+        for (size_t pos = 0; pos < states_.size(); ++pos) {
+            if (states_[pos] != TaskState::Pending) {
+                continue;
+            }
+
+            bool skipped = false;
+            for (size_t i = layout_.dependency_offsets[pos]; i < layout_.dependency_offsets[pos + 1]; ++i) {
+                if (InheritDependencyState(pos, layout_.dependencies[i])) {
+                    skipped = true;
+                    break;
+                }
+            }
+
+            if (!skipped) {
+                LaunchTask(slot_tasks_[pos], token, *counters_.front());
+            }
+        }
+    }
+
+    bool InheritDependencyState(size_t slot, size_t dep_slot) {
+        if (states_[dep_slot] == TaskState::Failed) {
+            auto& task = *tasks_[slot_tasks_[slot]];
+            const auto& dep = *tasks_[slot_tasks_[dep_slot]];
+            states_[slot] = TaskState::Failed;
+            task.error = dep.error;
+            task.error_source = dep.error_source;
+            return true;
+        }
+        if (states_[dep_slot] != TaskState::Executed) {
+            states_[slot] = TaskState::Cancelled;
+            return true;
+        }
+        return false;
+    }
+
+    TaskState& StateOf(SchedulerTaskId id) {
+        return states_[slots_[id]];
+    }
+
+    TaskState StateOf(SchedulerTaskId id) const {
+        return states_[slots_[id]];
+    }
+
+    void LaunchTask(SchedulerTaskId id, const CancellationToken& token, WorkerCounters& counters) {
+        if (IsExpired(id, token)) {
+            StateOf(id) = TaskState::Cancelled;
+            return;
+        }
+
+        if (tasks_[id]->IsAsync()) {
+            std::promise<void> finished;
+            auto outcome = finished.get_future();
+            if (LaunchAsyncTask(id, token, [&finished] { finished.set_value(); })) {
+                outcome.wait();
+            }
+            return;
+        }
+
+        const auto start = Clock::now();
+        try {
+            tasks_[id]->Execute();
+        } catch (...) {
+            RecordOutcome(id, std::current_exception(), Clock::now() - start, counters);
+            return;
+        }
+        RecordOutcome(id, nullptr, Clock::now() - start, counters);
+    }
+
+    bool LaunchAsyncTask(SchedulerTaskId id, const CancellationToken& token, std::function<void()> on_complete) {
+        if (IsExpired(id, token)) {
+            StateOf(id) = TaskState::Cancelled;
+            return false;
+        }
+
+        const auto start = Clock::now();
+        try {
+            tasks_[id]->Submit(token, deadlines_[id], [this, id, start, on_complete = std::move(on_complete)]
+                                                      (std::exception_ptr error, bool cancelled) {
+                if (cancelled) {
+                    StateOf(id) = TaskState::Cancelled;
+                } else {
+                    RecordOutcome(id, error, Clock::now() - start, *io_counters_);
+                }
+                on_complete();
+            });
+        } catch (...) {
+            RecordOutcome(id, std::current_exception(), Clock::now() - start, *io_counters_);
+            return false;
+        }
+        return true;
+    }
+
+    void RecordOutcome(SchedulerTaskId id, std::exception_ptr error, Clock::duration run_time,
+                       WorkerCounters& counters) {
+        run_times_[id] = run_time;
+        size_t slot = slots_[id];
+        if (error) {
+            states_[slot] = TaskState::Failed;
+            tasks_[id]->error = error;
+            tasks_[id]->error_source = id;
+            return;
+        }
+        counters.AddExecuted(run_time);
+        result_bytes_[slot] = tasks_[id]->ResultBytes();
+        counters.AddResultBytes(result_bytes_[slot]);
+        states_[slot] = TaskState::Executed;
+    }
+
+    void ValidateResources() const {
+        for (SchedulerTaskId id = 0; id < task_resources_.size(); ++id) {
+            for (const auto& requirement : task_resources_[id].requirements()) {
+                auto capacity = resource_capacity_.find(requirement.name);
+                if (capacity == resource_capacity_.end()) {
+                    throw std::invalid_argument("Task " + std::to_string(id) +
+                                                " requires unknown resource \"" + requirement.name + "\"");
+                }
+                if (requirement.amount > capacity->second) {
+                    throw std::invalid_argument("Task " + std::to_string(id) + " requires " +
+                                                std::to_string(requirement.amount) + " of resource \"" +
+                                                requirement.name + "\" with capacity " +
+                                                std::to_string(capacity->second));
+                }
+            }
+        }
+    }
+
+    bool IsSpillable(SchedulerTaskId id) const {
+        return tasks_[id]->spill_ops && StateOf(id) == TaskState::Executed
+            && !tasks_[id]->spilled.load(std::memory_order_relaxed);
+    }
+
+    bool SpillResult(SchedulerTaskId id) {
+        auto& task = *tasks_[id];
+        if (!IsSpillable(id)) {
+            return false;
+        }
+
+        std::string encoded = task.spill_ops->encode(task.getResult());
+        std::lock_guard lock(spill_mutex_);
+        if (task.spilled.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        task.spill_extent = spill_file_->append(encoded);
+        task.getResult().Reset();
+        task.spilled.store(true, std::memory_order_release);
+        spill_counters_->AddSpilled(result_bytes_[slots_[id]]);
+        return true;
+    }
+
+    void RestoreResult(SchedulerTaskId id) {
+        auto& task = *tasks_[id];
+        std::lock_guard lock(spill_mutex_);
+        if (!task.spilled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        task.spill_ops->decode(task.getResult(), spill_file_->read(task.spill_extent));
+        task.spilled.store(false, std::memory_order_release);
+        spill_counters_->AddResultBytes(result_bytes_[slots_[id]]);
+    }
+
+    template<typename T>
+    static const SpillOps* SpillOpsFor() {
+        if constexpr (requires(const T& value, std::byte* out, const std::byte* in) {
+                          ResultCodec<T>::Size(value);
+                          ResultCodec<T>::Write(value, out);
+                          { ResultCodec<T>::Read(in, size_t{}) } -> std::convertible_to<T>;
+                      }) {
+            static const SpillOps ops{
+                [](dts::Any& any) {
+                    const T& value = dts::AnyCast<T>(any);
+                    std::string bytes(ResultCodec<T>::Size(value), '\0');
+                    ResultCodec<T>::Write(value, reinterpret_cast<std::byte*>(bytes.data()));
+                    return bytes;
+                },
+                [](dts::Any& any, const std::string& bytes) {
+                    any.Emplace<T>(ResultCodec<T>::Read(
+                        reinterpret_cast<const std::byte*>(bytes.data()), bytes.size()));
+                },
+            };
+            return &ops;
+        } else {
+            return nullptr;
+        }
+    }
+
+    void EnsureCounters(size_t count) {
+        std::lock_guard lock(counters_mutex_);
+        while (counters_.size() < count) {
+            counters_.push_back(std::make_unique<WorkerCounters>());
+        }
+    }
+
+    template<typename T>
+    static size_t ApproximateBytes(const T& value) {
+        if constexpr (requires { value.size(); typename T::value_type; }) {
+            return sizeof(T) + value.size() * sizeof(typename T::value_type);
+        } else {
+            return sizeof(T);
+        }
+    }
+
+    std::span<const SchedulerTaskId> Dependencies(SchedulerTaskId id) const {
+        const auto& graph = dependency_graph_;
+        if (id + 1 >= graph.offsets.size()) {
+            return {};
+        }
+        return {graph.edges.data() + graph.offsets[id], graph.offsets[id + 1] - graph.offsets[id]};
+    }
+
+    bool IsExpired(SchedulerTaskId id, const CancellationToken& token) const {
+        if (token.isCancelled()) {
+            return true;
+        }
+        return deadlines_[id] != Clock::time_point::max() && Clock::now() >= deadlines_[id];
+    }
+
     template <typename T>
     T ResolveArg(T&& value) {
         return std::forward<T>(value);
@@ -157,20 +1615,52 @@ private:
         return future.get();
     }
 
+    template <typename T>
+    T ResolveArg(FutureResult<T>& future) {
+        return future.get();
+    }
+
+    template <typename T>
+    Channel<T>& ResolveArg(StreamResult<T>& stream) {
+        return stream.get();
+    }
+
+    template<typename CallableObj, typename... Args>
+    std::unique_ptr<Task> MakeTask(DependencyList& deps, CallableObj&& callable_object, Args&&... args) {
+        using TskImplmnttn = TaskImplementation<
+                                std::decay_t<CallableObj>,
+                                std::decay_t<Args>...>;
+
+        AddDependencies(deps, args...);
+        std::sort(deps.begin(), deps.end());
+        deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+
+        return std::make_unique<TskImplmnttn>(
+            this,
+            std::forward<CallableObj>(callable_object),
+            std::forward<Args>(args)...
+        );
+    }
+
     template<typename T>
-    void AddDependency(std::unordered_set<SchedulerTaskId>&, T&&) {
+    void AddDependency(DependencyList&, const T&) {
     }
 
     template<typename T>
-    void AddDependency(std::unordered_set<SchedulerTaskId>& deps, const FutureResult<T>& fut) {
-        deps.insert(fut.task_id_);
+    void AddDependency(DependencyList& deps, const FutureResult<T>& fut) {
+        deps.push_back(fut.task_id_);
+    }
+
+    template<typename T>
+    void AddDependency(DependencyList& deps, const StreamResult<T>& stream) {
+        deps.push_back(stream.task_id_);
     }
 
     template<typename... Args>
-    void AddDependencies(std::unordered_set<SchedulerTaskId>&) {}
+    void AddDependencies(DependencyList&) {}
 
     template<typename First, typename... Args>
-    void AddDependencies(std::unordered_set<SchedulerTaskId>& deps, First&& first, Args&&... args) {
+    void AddDependencies(DependencyList& deps, First&& first, Args&&... args) {
         AddDependency(deps, std::forward<First>(first));
         AddDependencies(deps, std::forward<Args>(args)...);
     }
@@ -194,7 +1684,7 @@ private:
         visited.insert(node);
         nodes.insert(node);
 
-        for (SchedulerTaskId dep : dependency_graph_[node]) {
+        for (SchedulerTaskId dep : Dependencies(node)) {
             if (DFS(dep, visited, nodes)) {
                 return true;
             }
@@ -207,7 +1697,30 @@ private:
 private:
     std::vector<std::unique_ptr<Task>> tasks_;
     SchedulerTaskId task_id_;
-    std::unordered_map<SchedulerTaskId, std::unordered_set<SchedulerTaskId>> dependency_graph_;
+    DependencyGraph dependency_graph_;
+    std::unordered_set<SchedulerTaskId> unresolved_refs_;
+    std::vector<Clock::time_point> deadlines_;
+    std::vector<TaskState> states_;
+    ExecutionLayout layout_;
+    std::vector<size_t> result_bytes_;
+    std::vector<size_t> result_nodes_;
+    std::vector<size_t> slots_;
+    std::vector<SchedulerTaskId> slot_tasks_;
+    std::vector<Clock::duration> run_times_;
+    std::atomic<uint64_t> tasks_added_ = 0;
+    std::atomic<uint64_t> edges_ = 0;
+    std::vector<std::unique_ptr<WorkerCounters>> counters_;
+    mutable std::mutex counters_mutex_;
+    std::vector<SchedulerTaskId> stream_tasks_;
+    std::unique_ptr<WorkerCounters> io_counters_ = std::make_unique<WorkerCounters>();
+    size_t memory_budget_ = 0;
+    std::vector<size_t> expected_bytes_;
+    std::vector<TaskResources> task_resources_;
+    std::unordered_map<std::string, uint64_t> resource_capacity_;
+    std::unique_ptr<WorkerCounters> spill_counters_ = std::make_unique<WorkerCounters>();
+    std::unique_ptr<SpillFile> spill_file_;
+    mutable std::mutex spill_mutex_;
+    std::unique_ptr<IoEventLoop> io_loop_;
 };
 
 
@@ -254,6 +1767,33 @@ public:
 
     friend class TTaskScheduler;
 
+private:
+    TTaskScheduler* task_scheduller_ptr_;
+    SchedulerTaskId task_id_;
+};
+
+
+template<typename T>
+class StreamResult {
+public:
+    using SchedulerTaskId = size_t;
+
+public:
+    StreamResult(TTaskScheduler* tsk_schdlr_ptr, SchedulerTaskId id)
+        : task_scheduller_ptr_(tsk_schdlr_ptr)
+        , task_id_(id) {}
+
+public:
+    Channel<T>& get() const {
+        return task_scheduller_ptr_->getChannel<T>(task_id_);
+    }
+
+    operator Channel<T>&() const {
+        return get();
+    }
+
+    friend class TTaskScheduler;
+
 private:
     TTaskScheduler* task_scheduller_ptr_;
     SchedulerTaskId task_id_;
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "stats.h"
+
+
+enum class ReadyQueuePolicy {
+    Fifo,
+    Lifo,
+    CriticalPathFirst,
+};
+
+
+struct SimulationOptions {
+    size_t workers = 1;
+    ReadyQueuePolicy policy = ReadyQueuePolicy::Fifo;
+    std::chrono::nanoseconds dispatch_overhead{0};
+};
+
+
+struct SimulationReport {
+    std::chrono::nanoseconds makespan{0};
+    std::chrono::nanoseconds critical_path{0};
+    double utilization = 0;
+    std::vector<std::chrono::nanoseconds> worker_busy;
+    LatencyHistogram queue_wait;
+    std::chrono::nanoseconds max_queue_wait{0};
+};
+
+
+class ScheduleSimulator {
+public:
+    using TaskId = size_t;
+
+public:
+    ScheduleSimulator(std::vector<std::vector<TaskId>> dependencies, std::vector<std::chrono::nanoseconds> costs)
+        : dependencies_(std::move(dependencies))
+        , costs_(std::move(costs))
+    {
+        const size_t count = dependencies_.size();
+        costs_.resize(count);
+        successors_.resize(count);
+        for (TaskId id = 0; id < count; ++id) {
+            for (TaskId dep : dependencies_[id]) {
+                if (dep >= count) {
+                    throw std::out_of_range("Task depends on unknown task " + std::to_string(dep));
+                }
+                successors_[dep].push_back(id);
+            }
+        }
+        order_ = TopologicalOrder();
+    }
+
+public:
+    void setCost(TaskId id, std::chrono::nanoseconds cost) {
+        costs_.at(id) = cost;
+    }
+
+    std::chrono::nanoseconds cost(TaskId id) const {
+        return costs_.at(id);
+    }
+
+    size_t size() const {
+        return dependencies_.size();
+    }
+
+    SimulationReport run(const SimulationOptions& options) const {
+        using Nanos = std::chrono::nanoseconds;
+        using Completion = std::pair<Nanos, size_t>;
+        using Ready = std::tuple<Nanos, int64_t, TaskId>;
+
+        const size_t count = dependencies_.size();
+        const size_t workers = std::max<size_t>(options.workers, 1);
+        const std::vector<Nanos> levels = BottomLevels();
+
+        SimulationReport report;
+        report.worker_busy.assign(workers, Nanos{0});
+        for (Nanos level : levels) {
+            report.critical_path = std::max(report.critical_path, level);
+        }
+
+        std::vector<size_t> remaining(count);
+        std::vector<Nanos> ready_at(count);
+        std::vector<TaskId> finished_task(workers);
+        std::vector<size_t> idle_workers;
+        for (size_t w = workers; w > 0; --w) {
+            idle_workers.push_back(w - 1);
+        }
+
+        std::priority_queue<Ready> ready;
+        std::priority_queue<Completion, std::vector<Completion>, std::greater<Completion>> running;
+        int64_t sequence = 0;
+        Nanos now{0};
+
+        auto make_ready = [&](TaskId id) {
+            ready_at[id] = now;
+            int64_t order = options.policy == ReadyQueuePolicy::Lifo ? sequence : -sequence;
+            Nanos priority = options.policy == ReadyQueuePolicy::CriticalPathFirst ? levels[id] : Nanos{0};
+            ready.emplace(priority, order, id);
+            ++sequence;
+        };
+
+        for (TaskId id : order_) {
+            remaining[id] = dependencies_[id].size();
+            if (remaining[id] == 0) {
+                make_ready(id);
+            }
+        }
+
+        while (!ready.empty() || !running.empty()) {
+            while (!ready.empty() && !idle_workers.empty()) {
+                TaskId id = std::get<2>(ready.top());
+                ready.pop();
+                size_t w = idle_workers.back();
+                idle_workers.pop_back();
+
+                Nanos wait = now - ready_at[id];
+                report.queue_wait.buckets[LatencyHistogram::BucketOf(wait)] += 1;
+                report.queue_wait.count += 1;
+                report.queue_wait.total += wait;
+                report.max_queue_wait = std::max(report.max_queue_wait, wait);
+
+                Nanos busy = costs_[id] + options.dispatch_overhead;
+                report.worker_busy[w] += busy;
+                finished_task[w] = id;
+                running.emplace(now + busy, w);
+            }
+
+            if (running.empty()) {
+                break;
+            }
+            now = running.top().first;
+            while (!running.empty() && running.top().first == now) {
+                size_t w = running.top().second;
+                running.pop();
+                idle_workers.push_back(w);
+                for (TaskId next : successors_[finished_task[w]]) {
+                    if (--remaining[next] == 0) {
+                        make_ready(next);
+                    }
+                }
+            }
+        }
+
+        report.makespan = now;
+        if (now.count() > 0) {
+            Nanos busy{0};
+            for (Nanos worker : report.worker_busy) {
+                busy += worker;
+            }
+            report.utilization = static_cast<double>(busy.count()) / (static_cast<double>(now.count()) * workers);
+        }
+        return report;
+    }
+
+private:
+    std::vector<TaskId> TopologicalOrder() const {
+        const size_t count = dependencies_.size();
+        std::vector<size_t> indegree(count);
+        std::vector<TaskId> order;
+        order.reserve(count);
+        for (TaskId id = 0; id < count; ++id) {
+            indegree[id] = dependencies_[id].size();
+            if (indegree[id] == 0) {
+                order.push_back(id);
+            }
+        }
+        for (size_t i = 0; i < order.size(); ++i) {
+            for (TaskId next : successors_[order[i]]) {
+                if (--indegree[next] == 0) {
+                    order.push_back(next);
+                }
+            }
+        }
+        if (order.size() != count) {
+            throw std::runtime_error("Detected cycle");
+        }
+        return order;
+    }
+
+    std::vector<std::chrono::nanoseconds> BottomLevels() const {
+        std::vector<std::chrono::nanoseconds> levels(dependencies_.size());
+        for (auto it = order_.rbegin(); it != order_.rend(); ++it) {
+            std::chrono::nanoseconds longest{0};
+            for (TaskId next : successors_[*it]) {
+                longest = std::max(longest, levels[next]);
+            }
+            levels[*it] = costs_[*it] + longest;
+        }
+        return levels;
+    }
+
+private:
+    std::vector<std::vector<TaskId>> dependencies_;
+    std::vector<std::chrono::nanoseconds> costs_;
+    std::vector<std::vector<TaskId>> successors_;
+    std::vector<TaskId> order_;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdio>
+#include <string>
+#include <system_error>
+
+
+class SpillFile {
+public:
+    struct Extent {
+        long offset = 0;
+        size_t size = 0;
+    };
+
+public:
+    SpillFile()
+        : file_(std::tmpfile())
+    {
+        if (!file_) {
+            throw std::system_error(errno, std::generic_category(), "tmpfile");
+        }
+    }
+
+    ~SpillFile() {
+        std::fclose(file_);
+    }
+
+    SpillFile(const SpillFile& other) = delete;
+
+    SpillFile& operator=(const SpillFile& other) = delete;
+
+public:
+    Extent append(const std::string& bytes) {
+        if (std::fseek(file_, 0, SEEK_END) != 0) {
+            throw std::system_error(errno, std::generic_category(), "fseek");
+        }
+        Extent extent{std::ftell(file_), bytes.size()};
+        if (std::fwrite(bytes.data(), 1, bytes.size(), file_) != bytes.size()) {
+            throw std::system_error(errno, std::generic_category(), "fwrite");
+        }
+        return extent;
+    }
+
+    std::string read(const Extent& extent) const {
+        std::string bytes(extent.size, '\0');
+        if (std::fseek(file_, extent.offset, SEEK_SET) != 0) {
+            throw std::system_error(errno, std::generic_category(), "fseek");
+        }
+        if (std::fread(bytes.data(), 1, bytes.size(), file_) != bytes.size()) {
+            throw std::system_error(errno, std::generic_category(), "fread");
+        }
+        return bytes;
+    }
+
+private:
+    std::FILE* file_;
+};
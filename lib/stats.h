@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+
+struct LatencyHistogram {
+    static constexpr size_t kBuckets = 40;
+
+    std::array<uint64_t, kBuckets> buckets{};
+    uint64_t count = 0;
+    std::chrono::nanoseconds total{0};
+
+    static size_t BucketOf(std::chrono::nanoseconds value) {
+        uint64_t ns = value.count() > 0 ? static_cast<uint64_t>(value.count()) : 0;
+        return std::min<size_t>(std::bit_width(ns), kBuckets - 1);
+    }
+
+    static std::chrono::nanoseconds BucketUpperBound(size_t bucket) {
+        return std::chrono::nanoseconds(bucket == 0 ? 0 : (int64_t{1} << bucket) - 1);
+    }
+
+    std::chrono::nanoseconds Percentile(double q) const {
+        uint64_t rank = static_cast<uint64_t>(q * count);
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+            seen += buckets[bucket];
+            if (seen > rank) {
+                return BucketUpperBound(bucket);
+            }
+        }
+        return BucketUpperBound(kBuckets - 1);
+    }
+};
+
+
+struct WorkerStats {
+    uint64_t tasks_executed = 0;
+    std::chrono::nanoseconds busy_time{0};
+    std::chrono::nanoseconds idle_time{0};
+    uint64_t steal_attempts = 0;
+    uint64_t steal_successes = 0;
+};
+
+
+struct SchedulerStats {
+    uint64_t tasks_added = 0;
+    uint64_t tasks_executed = 0;
+    uint64_t edges = 0;
+    uint64_t queue_depth_high_water = 0;
+    int64_t result_bytes_alive = 0;
+    uint64_t results_spilled = 0;
+    uint64_t bytes_spilled = 0;
+    std::vector<WorkerStats> workers;
+    LatencyHistogram run_time;
+    LatencyHistogram scheduling_latency;
+};
+
+
+class alignas(64) WorkerCounters {
+public:
+    void AddExecuted(std::chrono::nanoseconds run_time) {
+        Bump(tasks_executed_, 1);
+        Bump(busy_ns_, run_time.count());
+        Record(run_time_, run_time_total_ns_, run_time);
+    }
+
+    void AddSchedulingLatency(std::chrono::nanoseconds latency) {
+        Record(latency_, latency_total_ns_, latency);
+    }
+
+    void AddIdle(std::chrono::nanoseconds time) {
+        Bump(idle_ns_, time.count());
+    }
+
+    void AddStealAttempt(bool success) {
+        Bump(steal_attempts_, 1);
+        if (success) {
+            Bump(steal_successes_, 1);
+        }
+    }
+
+    void ObserveQueueDepth(uint64_t depth) {
+        if (depth > queue_high_water_.load(std::memory_order_relaxed)) {
+            queue_high_water_.store(depth, std::memory_order_relaxed);
+        }
+    }
+
+    void AddResultBytes(int64_t bytes) {
+        result_bytes_.store(result_bytes_.load(std::memory_order_relaxed) + bytes,
+                            std::memory_order_relaxed);
+    }
+
+    void AddSpilled(uint64_t bytes) {
+        Bump(results_spilled_, 1);
+        Bump(bytes_spilled_, bytes);
+        AddResultBytes(-static_cast<int64_t>(bytes));
+    }
+
+    void Collect(SchedulerStats& stats, WorkerStats& worker) const {
+        worker.tasks_executed += tasks_executed_.load(std::memory_order_relaxed);
+        worker.busy_time += std::chrono::nanoseconds(busy_ns_.load(std::memory_order_relaxed));
+        worker.idle_time += std::chrono::nanoseconds(idle_ns_.load(std::memory_order_relaxed));
+        worker.steal_attempts += steal_attempts_.load(std::memory_order_relaxed);
+        worker.steal_successes += steal_successes_.load(std::memory_order_relaxed);
+
+        stats.tasks_executed += worker.tasks_executed;
+        stats.queue_depth_high_water = std::max(stats.queue_depth_high_water,
+                                                queue_high_water_.load(std::memory_order_relaxed));
+        stats.result_bytes_alive += result_bytes_.load(std::memory_order_relaxed);
+        stats.results_spilled += results_spilled_.load(std::memory_order_relaxed);
+        stats.bytes_spilled += bytes_spilled_.load(std::memory_order_relaxed);
+        Merge(stats.run_time, run_time_, run_time_total_ns_);
+        Merge(stats.scheduling_latency, latency_, latency_total_ns_);
+    }
+
+private:
+    using Buckets = std::array<std::atomic<uint64_t>, LatencyHistogram::kBuckets>;
+
+private:
+    static void Bump(std::atomic<uint64_t>& counter, uint64_t delta) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    static void Record(Buckets& buckets, std::atomic<uint64_t>& total_ns, std::chrono::nanoseconds value) {
+        Bump(buckets[LatencyHistogram::BucketOf(value)], 1);
+        Bump(total_ns, value.count());
+    }
+
+    static void Merge(LatencyHistogram& histogram, const Buckets& buckets, const std::atomic<uint64_t>& total_ns) {
+        for (size_t bucket = 0; bucket < LatencyHistogram::kBuckets; ++bucket) {
+            uint64_t hits = buckets[bucket].load(std::memory_order_relaxed);
+            histogram.buckets[bucket] += hits;
+            histogram.count += hits;
+        }
+        histogram.total += std::chrono::nanoseconds(total_ns.load(std::memory_order_relaxed));
+    }
+
+private:
+    std::atomic<uint64_t> tasks_executed_ = 0;
+    std::atomic<uint64_t> busy_ns_ = 0;
+    std::atomic<uint64_t> idle_ns_ = 0;
+    std::atomic<uint64_t> steal_attempts_ = 0;
+    std::atomic<uint64_t> steal_successes_ = 0;
+    std::atomic<uint64_t> queue_high_water_ = 0;
+    std::atomic<int64_t> result_bytes_ = 0;
+    std::atomic<uint64_t> results_spilled_ = 0;
+    std::atomic<uint64_t> bytes_spilled_ = 0;
+    Buckets run_time_{};
+    Buckets latency_{};
+    std::atomic<uint64_t> run_time_total_ns_ = 0;
+    std::atomic<uint64_t> latency_total_ns_ = 0;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+class TaskCancelledError : public std::runtime_error {
+public:
+    explicit TaskCancelledError(size_t id)
+        : std::runtime_error("Task " + std::to_string(id) + " was cancelled")
+        , task_id(id)
+    {}
+
+public:
+    size_t task_id;
+};
+
+
+class TaskExecutionError : public std::runtime_error {
+public:
+    struct Failure {
+        size_t task_id;
+        std::exception_ptr error;
+    };
+
+public:
+    TaskExecutionError(std::vector<Failure> task_failures, std::vector<size_t> skipped_tasks)
+        : std::runtime_error(std::to_string(task_failures.size()) + " task(s) failed, "
+                             + std::to_string(skipped_tasks.size()) + " dependent task(s) skipped")
+        , failures(std::move(task_failures))
+        , skipped(std::move(skipped_tasks))
+    {}
+
+public:
+    std::vector<Failure> failures;
+    std::vector<size_t> skipped;
+};
+
+
+class TaskProcessError : public std::runtime_error {
+public:
+    TaskProcessError(int pid, const std::string& message)
+        : std::runtime_error(message)
+        , process_id(pid)
+    {}
+
+public:
+    int process_id;
+};
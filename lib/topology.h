@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+
+struct NumaNode {
+    size_t id;
+    std::vector<size_t> cpus;
+};
+
+
+class CpuTopology {
+public:
+    CpuTopology() = default;
+
+    // Memory-only nodes (HBM, CXL) have no CPUs to run workers on and are dropped, as in Detect().
+    explicit CpuTopology(std::vector<NumaNode> nodes)
+        : nodes_(std::move(nodes))
+    {
+        std::erase_if(nodes_, [](const NumaNode& node) { return node.cpus.empty(); });
+    }
+
+    static CpuTopology Detect() {
+        std::vector<size_t> allowed = AllowedCpus();
+        std::vector<NumaNode> nodes;
+
+        std::error_code ec;
+        std::filesystem::directory_iterator it("/sys/devices/system/node", ec);
+        for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+            std::string name = it->path().filename().string();
+            if (name.size() <= 4 || name.compare(0, 4, "node") != 0
+                || !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+                continue;
+            }
+
+            std::ifstream cpulist(it->path() / "cpulist");
+            std::string line;
+            std::getline(cpulist, line);
+
+            NumaNode node{std::stoul(name.substr(4)), {}};
+            for (size_t cpu : ParseCpuList(line)) {
+                if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+                    node.cpus.push_back(cpu);
+                }
+            }
+            if (!node.cpus.empty()) {
+                nodes.push_back(std::move(node));
+            }
+        }
+
+        if (nodes.empty()) {
+            nodes.push_back(NumaNode{0, std::move(allowed)});
+        }
+        std::sort(nodes.begin(), nodes.end(), [](const NumaNode& lhs, const NumaNode& rhs) {
+            return lhs.id < rhs.id;
+        });
+        return CpuTopology(std::move(nodes));
+    }
+
+    static std::vector<size_t> ParseCpuList(const std::string& list) {
+        std::vector<size_t> cpus;
+        size_t pos = 0;
+        while (pos < list.size()) {
+            size_t end = list.find(',', pos);
+            if (end == std::string::npos) {
+                end = list.size();
+            }
+            std::string range = list.substr(pos, end - pos);
+            pos = end + 1;
+            if (range.empty() || !::isdigit(range.front())) {
+                continue;
+            }
+
+            size_t dash = range.find('-');
+            size_t first = std::stoul(range.substr(0, dash));
+            size_t last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+            for (size_t cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    static bool PinCurrentThread(size_t cpu) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+
+    static std::vector<size_t> StealOrder(const std::vector<size_t>& worker_nodes, size_t worker) {
+        std::vector<size_t> order;
+        const size_t count = worker_nodes.size();
+        for (size_t step = 1; step < count; ++step) {
+            size_t victim = (worker + step) % count;
+            if (worker_nodes[victim] == worker_nodes[worker]) {
+                order.push_back(victim);
+            }
+        }
+        for (size_t step = 1; step < count; ++step) {
+            size_t victim = (worker + step) % count;
+            if (worker_nodes[victim] != worker_nodes[worker]) {
+                order.push_back(victim);
+            }
+        }
+        return order;
+    }
+
+public:
+    const std::vector<NumaNode>& nodes() const {
+        return nodes_;
+    }
+
+private:
+    static std::vector<size_t> AllowedCpus() {
+        std::vector<size_t> cpus;
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+#endif
+        if (cpus.empty()) {
+            size_t count = std::max(1u, std::thread::hardware_concurrency());
+            for (size_t cpu = 0; cpu < count; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+private:
+    std::vector<NumaNode> nodes_;
+};
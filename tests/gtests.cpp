@@ -1,9 +1,14 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <array>
 #include <cmath>
+#include <cstdio>
 #include <string>
 
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include "any_tests.cpp"
 #include "tuple_tests.cpp"
 #include "invoke_tests.cpp"
@@ -30,6 +35,14 @@ TEST(ApplyTests, ApplyWithTuple) {
 }
 
 
+TEST(ApplyTests, ApplyTransformedPassesTransformedArguments) {
+    Tuple<int, std::string> tuple(2, "ab");
+    auto doubled = [](const auto& value) { return value + value; };
+    auto func = [](int a, std::string b) { return std::to_string(a) + b; };
+    EXPECT_EQ(ApplyTransformed(func, tuple, doubled), "4abab");
+}
+
+
 
 TEST(SchedulerTests, BasicTaskExecution) {
     TTaskScheduler scheduler;
@@ -109,6 +122,25 @@ TEST(SchedulerTests, MixedFuturesAndValues) {
 
 
 
+TEST(SchedulerTests, TaskResultIsMovedIntoStorage) {
+    struct Counted {
+        explicit Counted(int* counter) : copies(counter) {}
+        Counted(const Counted& other) : copies(other.copies) { ++*copies; }
+        Counted(Counted&& other) noexcept = default;
+        int* copies;
+    };
+
+    int copies = 0;
+    TTaskScheduler scheduler;
+    auto id = scheduler.add([](int* counter) { return Counted(counter); }, &copies);
+
+    scheduler.executeAll();
+
+    EXPECT_EQ(scheduler.state(id), TTaskScheduler::TaskState::Executed);
+    EXPECT_EQ(copies, 0);
+}
+
+
 TEST(SchedulerTests, MemberFunctionViaNonConstRef) {
     struct TestClass {
         int mul(int a) { return a * factor++; }
@@ -139,4 +171,943 @@ TEST(SchedulerTests, MemberFunctionViaConstRef) {
     scheduler.executeAll();
 
     EXPECT_EQ(scheduler.getResult<int>(id), 12);
-}
\ No newline at end of file
+}
+
+TEST(SchedulerTests, CancelledTokenSkipsAllTasks) {
+    TTaskScheduler scheduler;
+    int calls = 0;
+
+    auto id1 = scheduler.add([&calls](int a) { ++calls; return a; }, 1);
+    auto id2 = scheduler.add([&calls](int a) { ++calls; return a + 1; }, scheduler.getFutureResult<int>(id1));
+
+    auto token = CancellationToken::Create();
+    token.cancel();
+    scheduler.executeAll(token);
+
+    EXPECT_EQ(calls, 0);
+    EXPECT_EQ(scheduler.state(id1), TTaskScheduler::TaskState::Cancelled);
+    EXPECT_EQ(scheduler.state(id2), TTaskScheduler::TaskState::Cancelled);
+    EXPECT_THROW(scheduler.getResult<int>(id2), TaskCancelledError);
+}
+
+
+TEST(SchedulerTests, CancellationFromInsideTaskSkipsRemaining) {
+    TTaskScheduler scheduler;
+    auto token = CancellationToken::Create();
+
+    auto id1 = scheduler.add([](CancellationToken t) { t.cancel(); return 1; }, token);
+    auto id2 = scheduler.add([](int a) { return a + 1; }, scheduler.getFutureResult<int>(id1));
+    auto id3 = scheduler.add([]() { return 3; });
+
+    scheduler.executeAll(token);
+
+    EXPECT_EQ(scheduler.getResult<int>(id1), 1);
+    EXPECT_EQ(scheduler.state(id2), TTaskScheduler::TaskState::Cancelled);
+    EXPECT_EQ(scheduler.state(id3), TTaskScheduler::TaskState::Cancelled);
+}
+
+
+TEST(SchedulerTests, ExpiredTaskDeadlineCancelsDownstreamOnly) {
+    TTaskScheduler scheduler;
+
+    auto id1 = scheduler.add([](int a) { return a; }, 1);
+    auto id2 = scheduler.add([](int a) { return a * 2; }, scheduler.getFutureResult<int>(id1));
+    auto id3 = scheduler.add([](int a) { return a * 3; }, 5);
+
+    scheduler.setDeadline(id1, TTaskScheduler::Clock::now() - std::chrono::seconds(1));
+    scheduler.executeAll();
+
+    EXPECT_EQ(scheduler.state(id1), TTaskScheduler::TaskState::Cancelled);
+    EXPECT_THROW(scheduler.getResult<int>(id2), TaskCancelledError);
+    EXPECT_EQ(scheduler.getResult<int>(id3), 15);
+}
+
+
+TEST(SchedulerTests, GraphTimeoutIsVisibleToCooperativeTasks) {
+    TTaskScheduler scheduler;
+    auto token = CancellationToken::WithTimeout(std::chrono::milliseconds(10));
+
+    auto id = scheduler.add([](CancellationToken t) {
+        int iterations = 0;
+        while (!t.isCancelled()) {
+            ++iterations;
+        }
+        return iterations;
+    }, token);
+
+    EXPECT_GT(scheduler.getResult<int>(id, token), 0);
+    EXPECT_TRUE(token.isCancelled());
+}
+
+
+TEST(SchedulerTests, FailedTaskDoesNotAbortIndependentBranches) {
+    TTaskScheduler scheduler;
+
+    auto id1 = scheduler.add([](int) -> int { throw std::invalid_argument("bad input"); }, 1);
+    auto id2 = scheduler.add([](int a) { return a + 1; }, scheduler.getFutureResult<int>(id1));
+    auto id3 = scheduler.add([](int a) { return a * 3; }, 5);
+
+    try {
+        scheduler.executeAll();
+        FAIL() << "executeAll must report the failure";
+    } catch (const TaskExecutionError& error) {
+        ASSERT_EQ(error.failures.size(), 1);
+        EXPECT_EQ(error.failures[0].task_id, id1);
+        EXPECT_EQ(error.skipped, std::vector<size_t>{id2});
+    }
+
+    EXPECT_EQ(scheduler.getResult<int>(id3), 15);
+    EXPECT_EQ(scheduler.state(id2), TTaskScheduler::TaskState::Failed);
+    EXPECT_THROW(scheduler.getResult<int>(id1), std::invalid_argument);
+    EXPECT_THROW(scheduler.getResult<int>(id2), std::invalid_argument);
+}
+
+
+TEST(SchedulerTests, ResetFailedRetriesOnlyFailedCone) {
+    TTaskScheduler scheduler;
+    int attempts = 0;
+    int independent_calls = 0;
+
+    auto id1 = scheduler.add([&attempts](int a) {
+        if (attempts++ == 0) {
+            throw std::runtime_error("transient");
+        }
+        return a;
+    }, 2);
+    auto id2 = scheduler.add([](int a) { return a * 10; }, scheduler.getFutureResult<int>(id1));
+    auto id3 = scheduler.add([&independent_calls]() { return ++independent_calls; });
+
+    EXPECT_THROW(scheduler.executeAll(), TaskExecutionError);
+
+    scheduler.resetFailed();
+    scheduler.executeAll();
+
+    EXPECT_EQ(scheduler.getResult<int>(id2), 20);
+    EXPECT_EQ(scheduler.getResult<int>(id3), 1);
+    EXPECT_EQ(attempts, 2);
+    EXPECT_EQ(independent_calls, 1);
+}
+
+
+TEST(SchedulerTests, FrozenGraphExecutesInDependencyOrder) {
+    TTaskScheduler scheduler;
+    std::vector<int> trace;
+
+    auto id1 = scheduler.add([&trace](int a) { trace.push_back(1); return a; }, 1);
+    auto id2 = scheduler.add([&trace](int a) { trace.push_back(2); return a + 1; }, scheduler.getFutureResult<int>(id1));
+    auto id3 = scheduler.add([&trace](int a) { trace.push_back(3); return a * 3; }, 5);
+    auto id4 = scheduler.add([&trace](int a, int b) { trace.push_back(4); return a + b; },
+                             scheduler.getFutureResult<int>(id3),
+                             scheduler.getFutureResult<int>(id2));
+
+    scheduler.freeze();
+    ASSERT_TRUE(scheduler.isFrozen());
+    scheduler.executeAll();
+
+    EXPECT_EQ(scheduler.getResult<int>(id4), 17);
+    EXPECT_EQ(trace, (std::vector<int>{1, 2, 3, 4}));
+}
+
+
+TEST(SchedulerTests, AddingTaskInvalidatesFrozenLayout) {
+    TTaskScheduler scheduler;
+
+    auto id1 = scheduler.add([]() -> int { throw std::runtime_error("boom"); });
+    scheduler.freeze();
+    auto id2 = scheduler.add([](int a) { return a; }, scheduler.getFutureResult<int>(id1));
+    auto id3 = scheduler.add([]() { return 7; });
+
+    EXPECT_FALSE(scheduler.isFrozen());
+    scheduler.freeze();
+    EXPECT_THROW(scheduler.executeAll(), TaskExecutionError);
+
+    EXPECT_EQ(scheduler.state(id2), TTaskScheduler::TaskState::Failed);
+    EXPECT_EQ(scheduler.getResult<int>(id3), 7);
+}
+
+
+TEST(SchedulerTests, ParallelExecutionMatchesSequential) {
+    TTaskScheduler scheduler;
+    std::vector<size_t> ids;
+
+    ids.push_back(scheduler.add([](int a) { return a; }, 1));
+    for (int i = 1; i < 200; ++i) {
+        ids.push_back(scheduler.add([](int a, int b) { return (a + b) % 1000; },
+                                    scheduler.getFutureResult<int>(ids[i / 2]),
+                                    scheduler.getFutureResult<int>(ids[i - 1])));
+    }
+
+    ExecutorOptions options;
+    options.threads = 4;
+    scheduler.executeParallel(options);
+
+    TTaskScheduler reference;
+    std::vector<size_t> reference_ids;
+    reference_ids.push_back(reference.add([](int a) { return a; }, 1));
+    for (int i = 1; i < 200; ++i) {
+        reference_ids.push_back(reference.add([](int a, int b) { return (a + b) % 1000; },
+                                              reference.getFutureResult<int>(reference_ids[i / 2]),
+                                              reference.getFutureResult<int>(reference_ids[i - 1])));
+    }
+    reference.executeAll();
+
+    for (size_t i = 0; i < ids.size(); ++i) {
+        EXPECT_EQ(scheduler.getResult<int>(ids[i]), reference.getResult<int>(reference_ids[i]));
+    }
+}
+
+
+TEST(SchedulerTests, ParallelExecutionIsolatesFailures) {
+    TTaskScheduler scheduler;
+
+    auto id1 = scheduler.add([]() -> int { throw std::runtime_error("boom"); });
+    auto id2 = scheduler.add([](int a) { return a; }, scheduler.getFutureResult<int>(id1));
+    auto id3 = scheduler.add([](int a) { return a * 2; }, 21);
+
+    ExecutorOptions options;
+    options.threads = 3;
+    EXPECT_THROW(scheduler.executeParallel(options), TaskExecutionError);
+
+    EXPECT_EQ(scheduler.state(id2), TTaskScheduler::TaskState::Failed);
+    EXPECT_EQ(scheduler.getResult<int>(id3), 42);
+}
+
+
+TEST(SchedulerTests, NumaAwareExecutionRecordsProducerNodes) {
+    TTaskScheduler scheduler;
+    std::atomic<bool> consumed = false;
+
+    auto id1 = scheduler.add([](size_t n) { return std::vector<int>(n, 1); }, 1000);
+    scheduler.add([&consumed]() {
+        for (int i = 0; i < 1000 && !consumed.load(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return 0;
+    });
+    auto id2 = scheduler.add([&consumed](const std::vector<int>& v) {
+        consumed.store(true);
+        return v.size();
+    }, scheduler.getFutureResult<std::vector<int>>(id1));
+
+    ExecutorOptions options;
+    options.threads = 2;
+    options.numa_aware = true;
+    options.topology = CpuTopology({NumaNode{0, {0}}, NumaNode{1, {0}}});
+    scheduler.executeParallel(options);
+
+    EXPECT_EQ(scheduler.getResult<size_t>(id2), 1000);
+    EXPECT_LT(scheduler.resultNode(id1), 2);
+    EXPECT_EQ(scheduler.resultNode(id2), scheduler.resultNode(id1));
+}
+
+
+TEST(TopologyTests, CpuLessNodesAreDropped) {
+    CpuTopology topology({NumaNode{0, {0}}, NumaNode{1, {}}});
+    ASSERT_EQ(topology.nodes().size(), 1);
+    EXPECT_EQ(topology.nodes()[0].id, 0);
+
+    TTaskScheduler scheduler;
+    auto id = scheduler.add([]() { return 7; });
+    ExecutorOptions options;
+    options.threads = 2;
+    options.numa_aware = true;
+    options.topology = CpuTopology({NumaNode{0, {}}});
+    scheduler.executeParallel(options);
+    EXPECT_EQ(scheduler.getResult<int>(id), 7);
+}
+
+
+TEST(TopologyTests, StealOrderPrefersLocalVictims) {
+    std::vector<size_t> worker_nodes = {0, 1, 0, 1, 0};
+    EXPECT_EQ(CpuTopology::StealOrder(worker_nodes, 0), (std::vector<size_t>{2, 4, 1, 3}));
+    EXPECT_EQ(CpuTopology::StealOrder(worker_nodes, 3), (std::vector<size_t>{1, 4, 0, 2}));
+    EXPECT_TRUE(CpuTopology::StealOrder({0}, 0).empty());
+}
+
+
+TEST(TopologyTests, ParseCpuList) {
+    EXPECT_EQ(CpuTopology::ParseCpuList("0-3,8,10-11\n"), (std::vector<size_t>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_TRUE(CpuTopology::ParseCpuList("").empty());
+    EXPECT_FALSE(CpuTopology::Detect().nodes().empty());
+}
+
+
+TEST(SchedulerTests, StatsCountTasksEdgesAndResultBytes) {
+    TTaskScheduler scheduler;
+
+    auto id1 = scheduler.add([](size_t n) { return std::vector<int>(n, 0); }, 100);
+    auto id2 = scheduler.add([](int a) { return a; }, 1);
+    scheduler.add([](const std::vector<int>& v, int a) { return v.size() + a; },
+                  scheduler.getFutureResult<std::vector<int>>(id1),
+                  scheduler.getFutureResult<int>(id2));
+
+    scheduler.executeAll();
+    SchedulerStats stats = scheduler.stats();
+
+    EXPECT_EQ(stats.tasks_added, 3);
+    EXPECT_EQ(stats.edges, 2);
+    EXPECT_EQ(stats.tasks_executed, 3);
+    EXPECT_EQ(stats.run_time.count, 3);
+    EXPECT_GE(stats.result_bytes_alive, static_cast<int64_t>(100 * sizeof(int)));
+}
+
+
+TEST(SchedulerTests, StatsAggregatePerWorkerCounters) {
+    TTaskScheduler scheduler;
+    for (int i = 0; i < 64; ++i) {
+        scheduler.add([](int a) { return a * a; }, i);
+    }
+
+    ExecutorOptions options;
+    options.threads = 4;
+    scheduler.executeParallel(options);
+    SchedulerStats stats = scheduler.stats();
+
+    ASSERT_EQ(stats.workers.size(), 4);
+    uint64_t executed = 0;
+    for (const auto& worker : stats.workers) {
+        executed += worker.tasks_executed;
+        EXPECT_GE(worker.steal_attempts, worker.steal_successes);
+    }
+    EXPECT_EQ(executed, 64);
+    EXPECT_EQ(stats.tasks_executed, 64);
+    EXPECT_EQ(stats.scheduling_latency.count, 64);
+    EXPECT_GE(stats.queue_depth_high_water, 1);
+}
+
+
+TEST(StatsTests, HistogramBuckets) {
+    LatencyHistogram histogram;
+    histogram.buckets[LatencyHistogram::BucketOf(std::chrono::nanoseconds(0))] += 1;
+    histogram.buckets[LatencyHistogram::BucketOf(std::chrono::nanoseconds(1000))] += 3;
+    histogram.count = 4;
+
+    EXPECT_EQ(LatencyHistogram::BucketOf(std::chrono::nanoseconds(1000)), 10);
+    EXPECT_EQ(histogram.Percentile(0.0), std::chrono::nanoseconds(0));
+    EXPECT_EQ(histogram.Percentile(0.99), std::chrono::nanoseconds(1023));
+}
+
+
+TEST(SchedulerTests, StreamingTaskFeedsConsumerThroughBoundedChannel) {
+    TTaskScheduler scheduler;
+
+    auto source = scheduler.addStream<int>(2, [](Channel<int>& out, int count) {
+        for (int i = 1; i <= count; ++i) {
+            out.push(i);
+        }
+    }, 1000);
+    auto squares = scheduler.addStream<long long>(2, [](Channel<long long>& out, Channel<int>& in) {
+        while (auto chunk = in.pop()) {
+            out.push(static_cast<long long>(*chunk) * *chunk);
+        }
+    }, scheduler.getStream<int>(source));
+    auto total = scheduler.add([](Channel<long long>& in) {
+        long long sum = 0;
+        while (auto chunk = in.pop()) {
+            sum += *chunk;
+        }
+        return sum;
+    }, scheduler.getStream<long long>(squares));
+
+    scheduler.executeAll();
+
+    EXPECT_EQ(scheduler.getResult<long long>(total), 333833500LL);
+    EXPECT_EQ(scheduler.getChannel<int>(source).capacity(), 2);
+}
+
+
+TEST(SchedulerTests, UnconsumedStreamIsCancelledInsteadOfTruncated) {
+    TTaskScheduler scheduler;
+
+    auto source = scheduler.addStream<int>(2, [](Channel<int>& out) {
+        for (int i = 0; i < 100; ++i) {
+            out.push(i);
+        }
+    });
+    auto drained = scheduler.addStream<int>(2, [](Channel<int>& out) {
+        out.push(1);
+    });
+    auto consumer = scheduler.add([](Channel<int>& in) {
+        int count = 0;
+        while (in.pop()) {
+            ++count;
+        }
+        return count;
+    }, scheduler.getStream<int>(drained));
+
+    ExecutorOptions options;
+    options.threads = 2;
+    scheduler.executeParallel(options);
+
+    EXPECT_EQ(scheduler.state(source), TTaskScheduler::TaskState::Cancelled);
+    EXPECT_THROW(scheduler.getChannel<int>(source), TaskCancelledError);
+    EXPECT_EQ(scheduler.getResult<int>(consumer), 1);
+    EXPECT_EQ(scheduler.state(drained), TTaskScheduler::TaskState::Executed);
+}
+
+
+TEST(SchedulerTests, StreamingProducerFailureReachesConsumer) {
+    TTaskScheduler scheduler;
+
+    auto source = scheduler.addStream<int>(4, [](Channel<int>& out) {
+        out.push(1);
+        throw std::runtime_error("producer broke");
+    });
+    auto consumer = scheduler.add([](Channel<int>& in) {
+        int count = 0;
+        while (in.pop()) {
+            ++count;
+        }
+        return count;
+    }, scheduler.getStream<int>(source));
+
+    ExecutorOptions options;
+    options.threads = 2;
+    try {
+        scheduler.executeParallel(options);
+        FAIL() << "executeParallel must report the producer failure";
+    } catch (const TaskExecutionError& error) {
+        EXPECT_EQ(error.failures.size(), 2);
+    }
+
+    EXPECT_EQ(scheduler.state(source), TTaskScheduler::TaskState::Failed);
+    EXPECT_THROW(scheduler.getResult<int>(consumer), std::runtime_error);
+}
+
+
+TEST(SchedulerTests, IsolatedTaskReturnsResultFromChildProcess) {
+    static int touched = 0;
+    TTaskScheduler scheduler;
+
+    auto id1 = scheduler.add([](int a) { return a + 1; }, 41);
+    auto id2 = scheduler.addIsolated([](int a) {
+        touched = a;
+        return static_cast<double>(a) / 2;
+    }, scheduler.getFutureResult<int>(id1));
+    auto id3 = scheduler.addIsolated([](size_t n) { return std::vector<int>(n, 7); }, 1000);
+    auto id4 = scheduler.addIsolated([](const std::string& s) { return s + s; }, std::string("ab"));
+
+    scheduler.executeAll();
+
+    EXPECT_DOUBLE_EQ(scheduler.getResult<double>(id2), 21.0);
+    EXPECT_EQ(scheduler.getResult<std::vector<int>>(id3), std::vector<int>(1000, 7));
+    EXPECT_EQ(scheduler.getResult<std::string>(id4), "abab");
+    EXPECT_EQ(touched, 0);
+}
+
+
+TEST(SchedulerTests, HungWorkerProcessIsKilledAfterTimeout) {
+    TTaskScheduler scheduler;
+    auto token = CancellationToken::Create();
+
+    auto id1 = scheduler.addIsolated(IsolationOptions{std::chrono::milliseconds(50), {}}, []() -> int {
+        while (true) {
+            pause();
+        }
+    });
+    auto id2 = scheduler.addIsolated(IsolationOptions{{}, token}, [](int a) {
+        return a + 1;
+    }, 1);
+    auto id3 = scheduler.addIsolated(IsolationOptions{{}, token}, []() -> int {
+        while (true) {
+            pause();
+        }
+    });
+
+    EXPECT_EQ(scheduler.getResult<int>(id2), 2);
+    token.cancel();
+    EXPECT_THROW(scheduler.executeAll(), TaskExecutionError);
+
+    EXPECT_EQ(scheduler.state(id1), TTaskScheduler::TaskState::Failed);
+    EXPECT_EQ(scheduler.state(id3), TTaskScheduler::TaskState::Failed);
+    EXPECT_THROW(scheduler.getResult<int>(id1), TaskProcessError);
+}
+
+
+TEST(SchedulerTests, CrashedWorkerProcessFailsOnlyItsTask) {
+    TTaskScheduler scheduler;
+
+    auto id1 = scheduler.addIsolated([]() -> int { std::abort(); });
+    auto id2 = scheduler.add([](int a) { return a; }, scheduler.getFutureResult<int>(id1));
+    auto id3 = scheduler.addIsolated([]() -> int { throw std::invalid_argument("bad"); });
+    auto id4 = scheduler.add([]() { return 4; });
+
+    EXPECT_THROW(scheduler.executeAll(), TaskExecutionError);
+
+    EXPECT_THROW(scheduler.getResult<int>(id1), TaskProcessError);
+    EXPECT_EQ(scheduler.state(id2), TTaskScheduler::TaskState::Failed);
+    try {
+        scheduler.getResult<int>(id3);
+        FAIL() << "child exception must be reported";
+    } catch (const TaskProcessError& error) {
+        EXPECT_STREQ(error.what(), "bad");
+    }
+    EXPECT_EQ(scheduler.getResult<int>(id4), 4);
+}
+
+
+TEST(SchedulerTests, AsyncReadDoesNotBlockWorker) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    TTaskScheduler scheduler;
+    auto read_id = scheduler.addAsyncRead(fds[0], 64);
+    auto length_id = scheduler.add([](const std::string& s) { return s.size(); },
+                                   scheduler.getFutureResult<std::string>(read_id));
+    scheduler.add([](int fd) {
+        std::string message = "hello";
+        ssize_t written = write(fd, message.data(), message.size());
+        close(fd);
+        return written;
+    }, fds[1]);
+
+    ExecutorOptions options;
+    options.threads = 1;
+    scheduler.executeParallel(options);
+    close(fds[0]);
+
+    EXPECT_EQ(scheduler.getResult<std::string>(read_id), "hello");
+    EXPECT_EQ(scheduler.getResult<size_t>(length_id), 5);
+}
+
+
+TEST(SchedulerTests, SilentAsyncReadIsCancelled) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    TTaskScheduler scheduler;
+    auto token = CancellationToken::Create();
+    auto read_id = scheduler.addAsyncRead(fds[0], 64);
+    auto length_id = scheduler.add([](const std::string& s) { return s.size(); },
+                                   scheduler.getFutureResult<std::string>(read_id));
+    scheduler.add([](CancellationToken t) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        t.cancel();
+        return 0;
+    }, token);
+
+    ExecutorOptions options;
+    options.threads = 2;
+    scheduler.executeParallel(options, token);
+
+    EXPECT_EQ(scheduler.state(read_id), TTaskScheduler::TaskState::Cancelled);
+    EXPECT_THROW(scheduler.getResult<size_t>(length_id), TaskCancelledError);
+
+    TTaskScheduler sequential;
+    auto timed_id = sequential.addAsyncRead(fds[0], 64);
+    sequential.setDeadline(timed_id, TTaskScheduler::Clock::now() + std::chrono::milliseconds(20));
+    sequential.executeAll();
+    EXPECT_EQ(sequential.state(timed_id), TTaskScheduler::TaskState::Cancelled);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+
+TEST(SchedulerTests, ManyAsyncReadsInFlight) {
+    constexpr int kReads = 64;
+    std::vector<std::array<int, 2>> pipes(kReads);
+    TTaskScheduler scheduler;
+    std::vector<size_t> ids;
+
+    for (auto& p : pipes) {
+        ASSERT_EQ(pipe(p.data()), 0);
+        ids.push_back(scheduler.addAsyncRead(p[0], 16));
+    }
+    scheduler.add([&pipes]() {
+        for (size_t i = 0; i < pipes.size(); ++i) {
+            std::string payload = std::to_string(i);
+            EXPECT_EQ(write(pipes[i][1], payload.data(), payload.size()), static_cast<ssize_t>(payload.size()));
+            close(pipes[i][1]);
+        }
+        return 0;
+    });
+
+    ExecutorOptions options;
+    options.threads = 2;
+    scheduler.executeParallel(options);
+
+    for (size_t i = 0; i < pipes.size(); ++i) {
+        EXPECT_EQ(scheduler.getResult<std::string>(ids[i]), std::to_string(i));
+        close(pipes[i][0]);
+    }
+}
+
+
+TEST(SchedulerTests, AsyncReadOfRegularFileInSequentialMode) {
+    FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    std::fputs("file contents", file);
+    std::fflush(file);
+    std::rewind(file);
+
+    TTaskScheduler scheduler;
+    auto id = scheduler.addAsyncRead(fileno(file), 4);
+    scheduler.executeAll();
+
+    EXPECT_EQ(scheduler.getResult<std::string>(id), "file");
+    std::fclose(file);
+}
+
+
+TEST(SchedulerTests, ParallelAsyncReadsOfRegularFiles) {
+    constexpr int kFiles = 16;
+    std::vector<FILE*> files;
+    TTaskScheduler scheduler;
+    std::vector<size_t> ids;
+
+    for (int i = 0; i < kFiles; ++i) {
+        FILE* file = std::tmpfile();
+        ASSERT_NE(file, nullptr);
+        std::fputs(std::string(1000, static_cast<char>('a' + i)).c_str(), file);
+        std::fflush(file);
+        std::rewind(file);
+        files.push_back(file);
+        ids.push_back(scheduler.addAsyncRead(fileno(file), 4096));
+    }
+
+    ExecutorOptions options;
+    options.threads = 2;
+    scheduler.executeParallel(options);
+
+    for (int i = 0; i < kFiles; ++i) {
+        EXPECT_EQ(scheduler.getResult<std::string>(ids[i]), std::string(1000, static_cast<char>('a' + i)));
+        std::fclose(files[i]);
+    }
+}
+
+
+TEST(SchedulerTests, ResultsWithoutSpillCodecStayInMemory) {
+    struct Point {
+        Point(int px, int py) : x(px), y(py) {}
+        int x;
+        int y;
+    };
+
+    TTaskScheduler scheduler;
+    auto flags = scheduler.add([](size_t n) { return std::vector<bool>(n, true); }, 1000);
+    auto points = scheduler.add([](int n) { return std::vector<Point>(n, Point(1, 2)); }, 1000);
+    auto count = scheduler.add([](const std::vector<bool>& v) { return v.size(); },
+                               scheduler.getFutureResult<std::vector<bool>>(flags));
+
+    scheduler.setMemoryBudget(64);
+    ExecutorOptions options;
+    options.threads = 2;
+    scheduler.executeParallel(options);
+
+    EXPECT_EQ(scheduler.getResult<size_t>(count), 1000);
+    EXPECT_FALSE(scheduler.isSpilled(flags));
+    EXPECT_FALSE(scheduler.isSpilled(points));
+    EXPECT_EQ(scheduler.getResult<std::vector<Point>>(points)[999].y, 2);
+}
+
+
+TEST(SchedulerTests, MemoryBudgetSpillsColdResults) {
+    TTaskScheduler scheduler;
+    std::vector<size_t> producers;
+    std::vector<size_t> consumers;
+    for (int i = 0; i < 16; ++i) {
+        producers.push_back(scheduler.add([](int value) { return std::vector<int>(1000, value); }, i));
+        consumers.push_back(scheduler.add([](const std::vector<int>& v) { return v.front() + v.back(); },
+                                          scheduler.getFutureResult<std::vector<int>>(producers.back())));
+    }
+
+    scheduler.setMemoryBudget(8 * 1024);
+    ExecutorOptions options;
+    options.threads = 2;
+    scheduler.executeParallel(options);
+    SchedulerStats stats = scheduler.stats();
+
+    EXPECT_GT(stats.results_spilled, 0);
+    EXPECT_GE(stats.bytes_spilled, 1000 * sizeof(int));
+    EXPECT_LE(stats.result_bytes_alive, 8 * 1024);
+
+    size_t spilled = 0;
+    for (int i = 0; i < 16; ++i) {
+        EXPECT_EQ(scheduler.getResult<int>(consumers[i]), 2 * i);
+        spilled += scheduler.isSpilled(producers[i]);
+        EXPECT_EQ(scheduler.getResult<std::vector<int>>(producers[i]), std::vector<int>(1000, i));
+        EXPECT_FALSE(scheduler.isSpilled(producers[i]));
+    }
+    EXPECT_GT(spilled, 0);
+}
+
+
+TEST(SchedulerTests, MemoryBudgetHoldsBackLargeOutputs) {
+    TTaskScheduler scheduler;
+    std::atomic<int> running = 0;
+    std::atomic<int> peak = 0;
+    std::vector<size_t> ids;
+    for (int i = 0; i < 4; ++i) {
+        ids.push_back(scheduler.add([&running, &peak]() {
+            int now = running.fetch_add(1) + 1;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            running.fetch_sub(1);
+            return std::string(6000, 'x');
+        }));
+        scheduler.setExpectedResultBytes(ids.back(), 6000);
+    }
+
+    scheduler.setMemoryBudget(10000);
+    ExecutorOptions options;
+    options.threads = 4;
+    scheduler.executeParallel(options);
+
+    EXPECT_EQ(peak.load(), 1);
+    for (size_t id : ids) {
+        EXPECT_EQ(scheduler.getResult<std::string>(id).size(), 6000);
+    }
+}
+
+
+TEST(SchedulerTests, ForwardReferencesAreCheckedForCycles) {
+    TTaskScheduler scheduler;
+
+    auto id0 = scheduler.add([](int a) { return a; }, scheduler.getFutureResult<int>(2));
+    auto id1 = scheduler.add([]() { return 1; });
+    EXPECT_THROW(scheduler.add([](int a) { return a; }, scheduler.getFutureResult<int>(id0)), std::runtime_error);
+    EXPECT_THROW(scheduler.add([](int a) { return a; }, scheduler.getFutureResult<int>(2)), std::runtime_error);
+    auto id2 = scheduler.add([](int a) { return a + 1; }, scheduler.getFutureResult<int>(id1));
+    auto id3 = scheduler.add([](int a) { return a * 10; }, scheduler.getFutureResult<int>(id0));
+
+    scheduler.executeAll();
+
+    EXPECT_EQ(id2, 2);
+    EXPECT_EQ(scheduler.getResult<int>(id0), 2);
+    EXPECT_EQ(scheduler.getResult<int>(id3), 20);
+}
+
+
+TEST(SchedulerTests, ResourcePoolsLimitConcurrency) {
+    TTaskScheduler scheduler;
+    scheduler.setResourceCapacity("db:2");
+    scheduler.setResourceCapacity("mem:1GB");
+
+    std::atomic<int> db_running = 0;
+    std::atomic<int> db_peak = 0;
+    std::atomic<int> mem_running = 0;
+    std::atomic<int> mem_peak = 0;
+    auto track = [](std::atomic<int>& running, std::atomic<int>& peak) {
+        int now = running.fetch_add(1) + 1;
+        int seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        running.fetch_sub(1);
+    };
+
+    std::vector<size_t> ids;
+    for (int i = 0; i < 6; ++i) {
+        ids.push_back(scheduler.add(TaskResources{"db:1"}, [&, i]() {
+            track(db_running, db_peak);
+            return i;
+        }));
+        ids.push_back(scheduler.add(TaskResources{"mem:512MB"}, [&, i]() {
+            track(mem_running, mem_peak);
+            return i;
+        }));
+    }
+    auto free_id = scheduler.add([]() { return -1; });
+
+    ExecutorOptions options;
+    options.threads = 4;
+    scheduler.executeParallel(options);
+
+    EXPECT_LE(db_peak.load(), 2);
+    EXPECT_LE(mem_peak.load(), 2);
+    for (size_t id : ids) {
+        EXPECT_EQ(scheduler.state(id), TTaskScheduler::TaskState::Executed);
+    }
+    EXPECT_EQ(scheduler.getResult<int>(free_id), -1);
+}
+
+
+TEST(SchedulerTests, TaskHeldByMemoryBudgetDoesNotKeepResources) {
+    TTaskScheduler scheduler;
+    scheduler.setResourceCapacity("db:1");
+    scheduler.setMemoryBudget(1000);
+    std::atomic<bool> other_ran = false;
+
+    auto waiter = scheduler.add([&other_ran]() {
+        for (int i = 0; i < 2000 && !other_ran.load(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return other_ran.load();
+    });
+    auto root = scheduler.add([]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return 0;
+    });
+    auto small = scheduler.add(TaskResources{"db:1"}, [&other_ran](int) {
+        other_ran.store(true);
+        return 1;
+    }, scheduler.getFutureResult<int>(root));
+    auto large = scheduler.add(TaskResources{"db:1"}, [](int) { return 2; },
+                               scheduler.getFutureResult<int>(root));
+    scheduler.setExpectedResultBytes(waiter, 600);
+    scheduler.setExpectedResultBytes(large, 600);
+
+    ExecutorOptions options;
+    options.threads = 2;
+    scheduler.executeParallel(options);
+
+    EXPECT_TRUE(scheduler.getResult<bool>(waiter));
+    EXPECT_EQ(scheduler.getResult<int>(small), 1);
+    EXPECT_EQ(scheduler.getResult<int>(large), 2);
+}
+
+
+TEST(SchedulerTests, ResourceRequirementsAreValidated) {
+    EXPECT_EQ(TaskResources::Parse("mem:512MB").amount, uint64_t{512} << 20);
+    EXPECT_EQ(TaskResources::Parse("io").amount, 1);
+    EXPECT_THROW(TaskResources{"io:lots"}, std::invalid_argument);
+    EXPECT_THROW(TaskResources{":1"}, std::invalid_argument);
+
+    TTaskScheduler scheduler;
+    scheduler.setResourceCapacity("io:1");
+    scheduler.add(TaskResources{"io:2"}, []() { return 0; });
+    EXPECT_THROW(scheduler.executeParallel(), std::invalid_argument);
+
+    TTaskScheduler unknown;
+    unknown.add(TaskResources{"gpu:1"}, []() { return 0; });
+    EXPECT_THROW(unknown.executeAll(), std::invalid_argument);
+}
+
+
+TEST(SimulatorTests, PoliciesAndWorkerCounts) {
+    using std::chrono::nanoseconds;
+    std::vector<std::vector<size_t>> dependencies = {{}, {}, {}, {}, {}, {4}, {5}};
+    std::vector<nanoseconds> costs(7, nanoseconds(10));
+    ScheduleSimulator simulator(dependencies, costs);
+
+    SimulationOptions options;
+    options.workers = 1;
+    SimulationReport serial = simulator.run(options);
+    EXPECT_EQ(serial.makespan, nanoseconds(70));
+    EXPECT_DOUBLE_EQ(serial.utilization, 1.0);
+    EXPECT_EQ(serial.critical_path, nanoseconds(30));
+
+    options.workers = 2;
+    SimulationReport fifo = simulator.run(options);
+    EXPECT_EQ(fifo.makespan, nanoseconds(50));
+    EXPECT_EQ(fifo.queue_wait.count, 7);
+
+    options.policy = ReadyQueuePolicy::CriticalPathFirst;
+    SimulationReport critical = simulator.run(options);
+    EXPECT_EQ(critical.makespan, nanoseconds(40));
+    EXPECT_DOUBLE_EQ(critical.utilization, 70.0 / 80.0);
+
+    EXPECT_THROW(ScheduleSimulator({{1}, {0}}, {}), std::runtime_error);
+}
+
+
+TEST(SimulatorTests, SimulatesRecordedRun) {
+    TTaskScheduler scheduler;
+    auto sleepy = [](int a) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        return a;
+    };
+    auto root = scheduler.add(sleepy, 0);
+    for (int i = 0; i < 4; ++i) {
+        scheduler.add(sleepy, scheduler.getFutureResult<int>(root));
+    }
+    scheduler.executeAll();
+
+    ScheduleSimulator simulator = scheduler.simulator();
+    ASSERT_EQ(simulator.size(), 5);
+    EXPECT_GE(simulator.cost(root), std::chrono::milliseconds(2));
+
+    SimulationOptions options;
+    options.workers = 4;
+    SimulationReport report = simulator.run(options);
+    EXPECT_EQ(report.critical_path, simulator.cost(root) + std::max({simulator.cost(1), simulator.cost(2),
+                                                                    simulator.cost(3), simulator.cost(4)}));
+    EXPECT_LE(report.makespan, report.critical_path + simulator.cost(2) + simulator.cost(3) + simulator.cost(4));
+    EXPECT_GE(report.makespan, report.critical_path);
+    EXPECT_EQ(report.worker_busy.size(), 4);
+}
+
+
+TEST(SchedulerTests, GraphBuilderCommitsStagedTasks) {
+    TTaskScheduler scheduler;
+    auto seed = scheduler.add([]() { return 1; });
+
+    auto builder = scheduler.builder();
+    builder.reserve(101, 200);
+    auto sum = builder.add([](int a, int b) { return a + b; },
+                           builder.getFutureResult<int>(seed + 2), builder.getFutureResult<int>(seed + 2));
+    auto prev = builder.add([](int a) { return a; }, scheduler.getFutureResult<int>(seed));
+    for (int i = 0; i < 99; ++i) {
+        prev = builder.add([](int a) { return a + 1; }, builder.getFutureResult<int>(prev));
+    }
+    EXPECT_EQ(builder.size(), 101);
+    EXPECT_EQ(scheduler.stats().tasks_added, 1);
+
+    builder.commit();
+    SchedulerStats stats = scheduler.stats();
+    EXPECT_EQ(stats.tasks_added, 102);
+    EXPECT_EQ(stats.edges, 101);
+
+    scheduler.executeAll();
+    EXPECT_EQ(scheduler.getResult<int>(prev), 100);
+    EXPECT_EQ(scheduler.getResult<int>(sum), 2);
+}
+
+
+TEST(SchedulerTests, FrozenLayoutKeepsTaskIdsWhenOrderDiffers) {
+    TTaskScheduler scheduler;
+    std::vector<size_t> ids;
+
+    auto builder = scheduler.builder();
+    for (int i = 0; i < 50; ++i) {
+        ids.push_back(builder.add([](int a) { return a + 1; }, builder.getFutureResult<int>(i + 1)));
+    }
+    ids.push_back(builder.add([]() { return 0; }));
+    builder.commit();
+
+    scheduler.freeze();
+    auto failing = scheduler.add([](int) -> int { throw std::runtime_error("boom"); },
+                                 scheduler.getFutureResult<int>(ids[25]));
+    auto skipped = scheduler.add([](int a) { return a; }, scheduler.getFutureResult<int>(failing));
+    scheduler.freeze();
+
+    ExecutorOptions options;
+    options.threads = 4;
+    EXPECT_THROW(scheduler.executeParallel(options), TaskExecutionError);
+
+    for (size_t i = 0; i < ids.size(); ++i) {
+        EXPECT_EQ(scheduler.getResult<int>(ids[i]), 50 - static_cast<int>(i));
+    }
+    EXPECT_EQ(scheduler.state(failing), TTaskScheduler::TaskState::Failed);
+    EXPECT_EQ(scheduler.state(skipped), TTaskScheduler::TaskState::Failed);
+}
+
+
+TEST(SchedulerTests, GraphBuilderRejectsInvalidGraphsAtomically) {
+    TTaskScheduler scheduler;
+    scheduler.reserve(16, 16);
+    auto seed = scheduler.add([]() { return 1; });
+
+    auto cyclic = scheduler.builder();
+    cyclic.add([](int a) { return a; }, cyclic.getFutureResult<int>(seed + 2));
+    cyclic.add([](int a) { return a; }, cyclic.getFutureResult<int>(seed + 1));
+    EXPECT_THROW(cyclic.commit(), std::runtime_error);
+
+    auto unknown = scheduler.builder();
+    unknown.add([](int a) { return a; }, unknown.getFutureResult<int>(42));
+    EXPECT_THROW(unknown.commit(), std::out_of_range);
+    EXPECT_EQ(scheduler.stats().tasks_added, 1);
+
+    auto stale = scheduler.builder();
+    stale.add([]() { return 2; });
+    scheduler.add([]() { return 3; });
+    EXPECT_THROW(stale.commit(), std::logic_error);
+
+    auto forward = scheduler.getFutureResult<int>(3);
+    scheduler.add([](int a) { return a; }, forward);
+    EXPECT_THROW(scheduler.add([](int a) { return a; }, scheduler.getFutureResult<int>(2)), std::runtime_error);
+    EXPECT_EQ(scheduler.stats().tasks_added, 3);
+}
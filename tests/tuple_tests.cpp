@@ -1,6 +1,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <cmath>
+#include <memory>
 #include <string>
 #include "hlprs_std/tuple.h"
 #include "hlprs_std/invoke.h"
@@ -32,4 +33,36 @@ TEST(TupleTests, TupleSize) {
 TEST(TupleTests, Empty) {
     Tuple<int, float, std::string> tuple(52, 3.14, "aaaaaaaaaaaaaaaaaaa");
     EXPECT_EQ(TupleSize<decltype(tuple)>::value, 3);
-}
\ No newline at end of file
+}
+
+TEST(TupleTests, CopyAndMove) {
+    Tuple<int, std::string> tuple(1, "value");
+    Tuple<int, std::string> copy(tuple);
+    EXPECT_EQ(Get<0>(copy), 1);
+    EXPECT_EQ(Get<1>(copy), "value");
+
+    Tuple<int, std::string> moved(std::move(copy));
+    EXPECT_EQ(Get<1>(moved), "value");
+
+    Tuple<std::string> single("one");
+    Tuple<std::string> single_copy(single);
+    EXPECT_EQ(Get<0>(single_copy), "one");
+}
+
+
+TEST(TupleTests, ForwardsWithoutCopies) {
+    struct Counted {
+        Counted(int* copies) : copies(copies) {}
+        Counted(const Counted& other) : copies(other.copies) { ++*copies; }
+        Counted(Counted&& other) noexcept = default;
+        int* copies;
+    };
+
+    int copies = 0;
+    Tuple<Counted, std::unique_ptr<int>> tuple(Counted(&copies), std::make_unique<int>(7));
+    EXPECT_EQ(copies, 0);
+
+    std::unique_ptr<int> ptr = Get<1>(std::move(tuple));
+    EXPECT_EQ(*ptr, 7);
+    EXPECT_EQ(Get<1>(tuple), nullptr);
+}